@@ -1,6 +1,8 @@
 #include "./app.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <iostream>
 
 #define GLFW_INCLUDE_VULKAN
@@ -13,6 +15,8 @@
 #include <tinyfiledialogs.h>
 
 #include "./motionUtil/bvhExporter.hpp"
+#include "./motionUtil/bvhParser.hpp"
+#include "./motionUtil/motionCache.hpp"
 #include "./resourceDirectory.hpp"
 #include "./util/popupUtils.hpp"
 #include "./util/errorUtils.hpp"
@@ -27,6 +31,7 @@ void App::initIkura() {
         ikura::RenderEngineInitConfig::defaultDebugSetting();
     renderConfig.applicationName = "IkulabMotionViewer";
     renderConfig.applicationVersion = VK_MAKE_VERSION(1, 2, 0);
+    renderConfig.cacheDirectory = getWritableResourceDirectory() / "cache";
 
     renderEngine = std::make_shared<ikura::RenderEngine>(renderConfig);
     renderEngine->createInstance();
@@ -112,65 +117,92 @@ void App::initIkura() {
     mainWindow->addVirtualWindow(imGuiVirtualWindow);
 }
 
-void App::setShapes(const char *filePath) {
-    std::vector<ikura::BasicVertex> vertices;
-    std::vector<ikura::BasicIndex> indices;
+App::LoadedModel
+App::buildModel(std::string filePath, BVHParserConfig parserConfig) const {
+    LoadedModel model;
 
-    if (filePath) {
-        // Joints ----------
-        animator->initFromBVH(filePath);
-        std::vector<std::shared_ptr<ikura::shapes::Shape>> shapes;
-        animator->generateBones(shapes);
+    // Joints ----------
+    model.animator = std::make_shared<Animator>(ui);
+    model.animator->initFromBVH(filePath, parserConfig);
+    if (parserConfig.progress->isCancelRequested()) {
+        throw parse_cancelled_error();
+    }
 
-        if (shapes.size() + NUM_OF_GROUPS_OTHER_THAN_JOINTS >
-            ikura::NUM_OF_MODEL_MATRIX) {
-            throw std::runtime_error("Too many Joints in loaded model.");
-        }
+    const ikura::GroupID numOfJoints = model.animator->getNumOfJoints();
+    if (numOfJoints + NUM_OF_GROUPS_OTHER_THAN_JOINTS >
+        ikura::MAX_NUM_OF_MODEL_MATRIX) {
+        throw std::runtime_error("Too many Joints in loaded model.");
+    }
 
-        // Add other than Joint object ----------
-        ikura::BasicIndex baseIndex =
-            shapes.back()->getBaseIndex() + shapes.back()->getVertices().size();
-
-        // DebugObj
-        auto debugObj = std::make_shared<ikura::shapes::DirectionDebugObject>(
-            40.0, AXIS_OBJ_GROUP_ID);
-        debugObj->setBaseIndex(baseIndex);
-        baseIndex += debugObj->getVertices().size();
-        shapes.push_back(debugObj);
-
-        // Floor
-        auto floor = std::make_shared<ikura::shapes::GridFloor>(
-            1000.0, 1000.0, 1, 10, 10, glm::vec3(0.2, 0.9, 0.2),
-            FLOOR_GROUP_ID);
-        floor->setBaseIndex(baseIndex);
-        // baseIndex += floor->getVertices().size();
-        shapes.push_back(floor);
-
-        // Register all Vertices / Indices ----------
-        for (auto &shape : shapes) {
-            vertices.insert(vertices.end(), shape->getVertices().begin(),
-                            shape->getVertices().end());
-            indices.insert(indices.end(), shape->getIndices().begin(),
-                           shape->getIndices().end());
-        }
+    model.animator->generateBoneInstances(model.boneInstances);
 
-        modelLoaded = true;
-    } else {
-        auto defaultShape = std::make_shared<ikura::shapes::SeparatedColorCube>(
-            100, 100, 100, glm::vec3(0, 0, 0),
-            std::array<glm::vec3, 6>{glm::vec3(0, 0, 1), glm::vec3(0, 1, 0),
-                                     glm::vec3(0, 1, 1), glm::vec3(1, 0, 0),
-                                     glm::vec3(1, 0, 1), glm::vec3(1, 1, 0)},
-            0);
-        vertices = defaultShape->getVertices();
-        indices = defaultShape->getIndices();
-    }
+    return model;
+}
 
-    mainRenderContent->setVertices(vertices);
-    mainRenderContent->setIndices(indices);
+/**
+ * @brief Upload the meshes of all objects.
+ *
+ * Loaded models only change the instances drawing them, so the vertices are
+ * uploaded once regardless of the number of joints.
+ */
+void App::setupMeshes() {
+    auto addMesh = [this](const ikura::shapes::Shape &shape) {
+        return mainRenderContent->addMesh(shape.getVertices(),
+                                          shape.getIndices());
+    };
+
+    meshes.defaultShape = addMesh(ikura::shapes::SeparatedColorCube(
+        100, 100, 100, glm::vec3(0, 0, 0),
+        std::array<glm::vec3, 6>{glm::vec3(0, 0, 1), glm::vec3(0, 1, 0),
+                                 glm::vec3(0, 1, 1), glm::vec3(1, 0, 0),
+                                 glm::vec3(1, 0, 1), glm::vec3(1, 1, 0)},
+        0));
+
+    // Joints
+    meshes.rootJoint = addMesh(ikura::shapes::SingleColorCube(
+        2.0, 2.0, 2.0, glm::vec3(0.0, 0.0, 0.0), glm::vec3(1.0, 0.0, 0.0), 0));
+    meshes.bone = addMesh(ikura::shapes::OctahedronBone(1.0, 0));
+    meshes.jointSphere = addMesh(ikura::shapes::SingleColorSphere(
+        1.0, 10, 10, glm::vec3(0.0, 0.0, 0.0), glm::vec3(0.8, 0.8, 0.8), 0));
+
+    // Other than Joint objects
+    meshes.axisObj = addMesh(ikura::shapes::DirectionDebugObject(40.0, 0));
+    meshes.floor = addMesh(ikura::shapes::GridFloor(
+        1000.0, 1000.0, 1, 10, 10, glm::vec3(0.2, 0.9, 0.2), 0));
 
     mainRenderContent->uploadVertexBuffer();
     mainRenderContent->uploadIndexBuffer();
+
+    setDefaultInstances();
+    mainRenderContent->commitUploadedBuffers();
+}
+
+/// Draw the default shape, which is shown until a model is loaded.
+void App::setDefaultInstances() {
+    mainRenderContent->clearInstances();
+    mainRenderContent->addInstances(meshes.defaultShape,
+                                    {ikura::BasicInstance(0)});
+
+    mainRenderContent->uploadInstanceBuffer();
+}
+
+/// Draw the skeleton of `model` and the objects following its joints.
+void App::setModelInstances(const LoadedModel &model) {
+    const ikura::GroupID numOfJoints = model.animator->getNumOfJoints();
+
+    mainRenderContent->clearInstances();
+    mainRenderContent->addInstances(meshes.rootJoint,
+                                    model.boneInstances.rootJoints);
+    mainRenderContent->addInstances(meshes.bone, model.boneInstances.bones);
+    mainRenderContent->addInstances(meshes.jointSphere,
+                                    model.boneInstances.jointSpheres);
+    mainRenderContent->addInstances(
+        meshes.axisObj,
+        {ikura::BasicInstance(numOfJoints + AXIS_OBJ_GROUP_OFFSET)});
+    mainRenderContent->addInstances(
+        meshes.floor, {ikura::BasicInstance(numOfJoints + FLOOR_GROUP_OFFSET)});
+
+    mainRenderContent->uploadInstanceBuffer();
 }
 
 void App::initContexts() {
@@ -192,15 +224,16 @@ void App::setGlfwWindowEvents(GLFWwindow *window) {
 }
 
 void App::selectFileAndInitShapes() {
-    const char *filterPattern[1] = {"*.bvh"};
+    const char *filterPattern[2] = {"*.bvh", "*" MOTION_CACHE_EXTENSION};
 
-    auto filePath = tinyfd_openFileDialog("Select Motion Data", NULL, 1,
-                                          filterPattern, "BVH file", 0);
+    auto filePath =
+        tinyfd_openFileDialog("Select Motion Data", NULL, 2, filterPattern,
+                              "BVH file / Motion cache file", 0);
     if (filePath == NULL) {
         return;
     }
 
-    setShapes(filePath);
+    startLoadingModel(filePath);
 }
 
 void App::selectFileAndExportLoopRange() {
@@ -212,48 +245,270 @@ void App::selectFileAndExportLoopRange() {
         return;
     }
 
-    exportLoopRangeToBvhFile(animator, filePath,
-                             ui->config.exportAllPositionChannel);
+    try {
+        exportLoopRangeToBvhFile(animator, filePath,
+                                 ui->config.exportAllPositionChannel);
+    } catch (const parse_failed_error &e) {
+        // frames of lazily loaded motion are decoded while exporting
+        std::error_code ec;
+        std::filesystem::remove(filePath, ec);
+
+        std::string msg;
+        msg += "Failed to export ";
+        msg += filePath;
+        msg += "\n";
+        msg += e.what();
+        msg += "\n";
+        msg += e.where();
+        LOG(ERROR) << msg;
+        showErrorPopup(msg);
+    }
+}
+
+// ----------------------------------------
+// Model loading
+// ----------------------------------------
+
+/**
+ * @brief Start loading `filePath` on a loader thread.
+ *
+ * The current model keeps playing until swapLoadedModel() swaps in the new
+ * one. A model being loaded is cancelled.
+ */
+void App::startLoadingModel(const char *filePath) {
+    cancelLoadingModel();
+
+    loadingFilePath = filePath;
+    loadingProgress = std::make_shared<BVHParseProgress>();
+
+    BVHParserConfig parserConfig;
+    parserConfig.lazyMotionDecoding = ui->config.lazyMotionLoading;
+    if (ui->config.loadFrameRange) {
+        parserConfig.firstFrame = ui->config.loadFirstFrameNum - 1;
+        parserConfig.lastFrame = ui->config.loadLastFrameNum - 1;
+        parserConfig.frameStep = ui->config.loadFrameStep;
+    }
+    parserConfig.progress = loadingProgress;
+    loadingModel = std::async(std::launch::async, &App::buildModel, this,
+                              loadingFilePath, parserConfig);
+}
+
+/**
+ * @brief Cancel loading without waiting for the loader thread.
+ *
+ * The loader thread is joined by releaseCancelledLoadingModels() once it
+ * has stopped.
+ */
+void App::cancelLoadingModel() {
+    if (!loadingModel.valid()) {
+        return;
+    }
+
+    loadingProgress->cancelRequested = true;
+    cancelledLoadingModels.push_back(std::move(loadingModel));
+    loadingProgress.reset();
+}
+
+/**
+ * @brief Drop the results of cancelled loader threads which have stopped.
+ *
+ * @param wait if true, wait for all cancelled loader threads.
+ */
+void App::releaseCancelledLoadingModels(bool wait) {
+    auto isReleasable = [wait](std::future<LoadedModel> &model) {
+        if (!wait && model.wait_for(std::chrono::seconds(0)) !=
+                         std::future_status::ready) {
+            return false;
+        }
+        try {
+            model.get();
+        } catch (const std::exception &) {
+            // result of cancelled loading is not used, including errors
+        }
+        return true;
+    };
+
+    cancelledLoadingModels.erase(
+        std::remove_if(cancelledLoadingModels.begin(),
+                       cancelledLoadingModels.end(), isReleasable),
+        cancelledLoadingModels.end());
+}
+
+/**
+ * @brief Start uploading the loaded model if the loader thread has finished.
+ *
+ * The model is swapped in by commitUploadedModel() once its instances have
+ * been uploaded.
+ * If loading failed, the error is shown in a popup and the current model
+ * is kept.
+ */
+void App::swapLoadedModel() {
+    releaseCancelledLoadingModels(false);
+
+    if (uploadingAnimator || !loadingModel.valid() ||
+        loadingModel.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready) {
+        return;
+    }
+
+    LoadedModel model;
+    try {
+        model = loadingModel.get();
+    } catch (const parse_cancelled_error &) {
+        loadingProgress.reset();
+        return;
+    } catch (const parse_failed_error &e) {
+        loadingProgress.reset();
+
+        std::string msg;
+        msg += "Failed to load ";
+        msg += loadingFilePath;
+        msg += "\n";
+        msg += e.what();
+        msg += "\n";
+        msg += e.where();
+        LOG(ERROR) << msg;
+        showErrorPopup(msg);
+        return;
+    } catch (const std::exception &e) {
+        // also catches errors other than std::runtime_error, e.g.
+        // std::bad_alloc, which would otherwise terminate the app
+        loadingProgress.reset();
+
+        std::string msg;
+        msg += "Failed to load ";
+        msg += loadingFilePath;
+        msg += "\n";
+        msg += e.what();
+        LOG(ERROR) << msg;
+        showErrorPopup(msg);
+        return;
+    }
+    loadingProgress.reset();
+
+    // The current model keeps being drawn while the new instances stream in.
+    setModelInstances(model);
+    uploadingAnimator = model.animator;
+}
+
+/**
+ * @brief Start drawing the uploaded model once its instances have been
+ * uploaded.
+ *
+ * @param wait if true, wait for the upload instead of returning.
+ */
+void App::commitUploadedModel(bool wait) {
+    if (!uploadingAnimator ||
+        (!wait && !mainRenderContent->isUploadCompleted())) {
+        return;
+    }
+
+    // the previous buffers are released once the frames using them retire
+    mainRenderContent->commitUploadedBuffers();
+
+    animator = std::move(uploadingAnimator);
+    animator->setLoopEnabled(ui->animationControlWindow.modeIndex ==
+                             UI::AnimationControlWindow::MODE_INDEX_EDIT);
+    animator->updateUIRotationOrder();
+    if (ui->config.bakeJointMatrices) {
+        animator->startBakingJointMatrices();
+    }
+    modelLoaded = true;
+}
+
+bool App::isLoadingModel() const { return loadingModel.valid(); }
+
+/**
+ * @brief Stop drawing the current model, e.g. when its frames cannot be
+ * decoded.
+ *
+ * A model being uploaded is drawn right away. Otherwise the default shape
+ * is drawn.
+ */
+void App::unloadModel() {
+    modelLoaded = false;
+    animator = std::make_shared<Animator>(ui);
+
+    if (uploadingAnimator) {
+        commitUploadedModel(true);
+        return;
+    }
+    setDefaultInstances();
+    mainRenderContent->commitUploadedBuffers();
+}
+
+/**
+ * @brief Write the joint matrices of the current frame to `modelMatrices`.
+ *
+ * Frames of lazily loaded motion are decoded here. If a frame line is
+ * invalid, the error is shown in a popup and false is returned.
+ */
+bool App::generateJointMatrices() {
+    modelMatrices.resize(animator->getNumOfJoints() +
+                         NUM_OF_GROUPS_OTHER_THAN_JOINTS);
+    try {
+        animator->generateModelMatrices(modelMatrices.data());
+    } catch (const parse_failed_error &e) {
+        std::string msg;
+        msg += "Failed to decode a frame of ";
+        msg += animator->getSourceFilePath();
+        msg += "\n";
+        msg += e.what();
+        msg += "\n";
+        msg += e.where();
+        LOG(ERROR) << msg;
+        showErrorPopup(msg);
+        return false;
+    }
+    return true;
 }
 
 void App::updateMatrices() {
     auto currentFrame = mainWindow->getCurrentFrameIndex();
-    ikura::BasicModelMatUBO modelMat;
-    ikura::BasicSceneMatUBO sceneMat;
+    ikura::BasicSceneMatPushConstant sceneMat;
 
-    if (modelLoaded) {
-        if (!ui->animationControlWindow.isSeekBarDragging) {
-            animator->updateAnimator(appEngine->getDeltaTime());
-        }
+    // Joints
+    if (modelLoaded && !ui->animationControlWindow.isSeekBarDragging) {
+        animator->updateAnimator(appEngine->getDeltaTime());
+    }
+    // a model whose frames fail to decode is unloaded
+    while (modelLoaded && !generateJointMatrices()) {
+        unloadModel();
+    }
 
-        // Joints
-        auto modelMat4s = animator->generateModelMatrices();
-        for (int i = 0; i < ikura::NUM_OF_MODEL_MATRIX; i++) {
-            modelMat.model[i] = modelMat4s[i];
-        }
+    // upload only the groups in use
+    const ikura::GroupID numOfJoints =
+        modelLoaded ? animator->getNumOfJoints() : 0;
+    const size_t numOfModelMatrices =
+        modelLoaded ? numOfJoints + NUM_OF_GROUPS_OTHER_THAN_JOINTS : 1;
+    // built on the host, where culling reads them too
+    modelMatrices.resize(numOfModelMatrices);
 
+    if (modelLoaded) {
         // Other objects
-        if (ui->showFloor) {
-            modelMat.model[FLOOR_GROUP_ID] = glm::mat4(1.0);
-        } else {
-            modelMat.model[FLOOR_GROUP_ID] = glm::mat4(0.0);
-        }
-
-        if (ui->showAxisObject) {
-            modelMat.model[AXIS_OBJ_GROUP_ID] = glm::mat4(1.0);
-        } else {
-            modelMat.model[AXIS_OBJ_GROUP_ID] = glm::mat4(0.0);
-        }
+        // hidden ones are skipped when drawing
+        const ikura::GroupID floorGroupID = numOfJoints + FLOOR_GROUP_OFFSET;
+        modelMatrices[floorGroupID] = glm::mat4(1.0);
+        mainRenderContent->setGroupVisible(floorGroupID, ui->showFloor);
+
+        const ikura::GroupID axisObjGroupID =
+            numOfJoints + AXIS_OBJ_GROUP_OFFSET;
+        modelMatrices[axisObjGroupID] = glm::mat4(1.0);
+        mainRenderContent->setGroupVisible(axisObjGroupID,
+                                           ui->showAxisObject);
     } else {
-        modelMat.model[0] = glm::mat4(1.0);
+        modelMatrices[0] = glm::mat4(1.0);
     }
 
-    // global scaling
-    for (auto &m : modelMat.model) {
-        m = glm::scale(glm::mat4(1.0), glm::vec3(0.1)) * m;
-    }
+    // the mapped buffer is only written, sequentially
+    std::copy(modelMatrices.begin(), modelMatrices.end(),
+              mainRenderContent->getMappedModelMatrices(currentFrame,
+                                                        numOfModelMatrices));
+    mainRenderContent->flushModelMatrices(currentFrame, numOfModelMatrices);
 
-    sceneMat.view = camera->generateViewMat();
+    // global scaling is applied to all objects through the view matrix
+    sceneMat.view = camera->generateViewMat() *
+                    glm::scale(glm::mat4(1.0), glm::vec3(0.1));
     sceneMat.proj = glm::perspective(glm::radians(45.0f),
                                      mainWindow->getWidth() /
                                          (float)mainWindow->getHeight(),
@@ -261,12 +516,16 @@ void App::updateMatrices() {
     // Convert to RightHand Z-up
     sceneMat.proj[1][1] *= -1;
 
-    mainRenderContent->updateUniformBuffer(currentFrame, modelMat, sceneMat);
+    mainRenderContent->setSceneMatrix(sceneMat);
+
+    // Culling ----------
+    mainRenderContent->setFrustumCullingEnabled(ui->enableFrustumCulling);
+    mainRenderContent->cullInstances(currentFrame, modelMatrices.data());
 }
 
 App::App() {
     initIkura();
-    setShapes(nullptr);
+    setupMeshes();
     initContexts();
     animator = std::make_shared<Animator>(ui);
 }
@@ -277,6 +536,9 @@ void App::run() {
     while (!appEngine->shouldTerminated()) {
         appEngine->vSync();
 
+        swapLoadedModel();
+        commitUploadedModel();
+
         camera->updateCamera(
             mouse, keyboard,
             std::any_of(mainWindow->getVirtualWindows().begin(),
@@ -293,5 +555,7 @@ void App::run() {
         appEngine->destroyClosedWindow();
     }
 
+    cancelLoadingModel();
+    releaseCancelledLoadingModels(true);
     renderEngine->waitForDeviceIdle();
 }
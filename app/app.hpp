@@ -1,6 +1,9 @@
 #pragma once
 
+#include <future>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <ikura/ikura.hpp>
 
@@ -14,8 +17,10 @@ class App {
     // Variables ==========
     // Constants ----------
     const int NUM_OF_GROUPS_OTHER_THAN_JOINTS = 2;
-    const ikura::GroupID AXIS_OBJ_GROUP_ID = ikura::NUM_OF_MODEL_MATRIX - 3;
-    const ikura::GroupID FLOOR_GROUP_ID = ikura::NUM_OF_MODEL_MATRIX - 2;
+    // Groups other than joints follow the joints, GroupID is
+    // (number of joints + offset)
+    const ikura::GroupID AXIS_OBJ_GROUP_OFFSET = 0;
+    const ikura::GroupID FLOOR_GROUP_OFFSET = 1;
 
     // ikura objects ----------
     std::unique_ptr<ikura::AppEngine> appEngine;
@@ -41,11 +46,42 @@ class App {
 
     // Others ----------
     std::shared_ptr<Animator> animator;
+    /// Model matrices of the current frame, [GroupID]
+    std::vector<glm::mat4> modelMatrices;
+
+    // Meshes ----------
+    /// Meshes uploaded once at startup, drawn for each group with instances.
+    /// GroupID of their vertices is 0.
+    struct Meshes {
+        ikura::BasicRenderContent::Mesh defaultShape;
+        ikura::BasicRenderContent::Mesh rootJoint;
+        ikura::BasicRenderContent::Mesh bone;
+        ikura::BasicRenderContent::Mesh jointSphere;
+        ikura::BasicRenderContent::Mesh axisObj;
+        ikura::BasicRenderContent::Mesh floor;
+    } meshes;
+
+    // Model loading ----------
+    /// Animator and bone instances built on the loader thread.
+    struct LoadedModel {
+        std::shared_ptr<Animator> animator;
+        Animator::BoneInstances boneInstances;
+    };
+    std::future<LoadedModel> loadingModel;
+    /// Loader threads being cancelled. Their futures are dropped once ready,
+    /// as destroying a pending std::async future waits for the thread.
+    std::vector<std::future<LoadedModel>> cancelledLoadingModels;
+    std::shared_ptr<BVHParseProgress> loadingProgress;
+    std::string loadingFilePath;
+    /// Animator of the model whose shapes are being uploaded
+    std::shared_ptr<Animator> uploadingAnimator;
 
     // Functions ==========
     // Init ----------
     void initIkura();
-    void setShapes(const char *filePath);
+    void setupMeshes();
+    void setDefaultInstances();
+    void setModelInstances(const LoadedModel &model);
     void initContexts();
     void setGlfwWindowEvents(GLFWwindow *window);
 
@@ -53,7 +89,19 @@ class App {
     void selectFileAndInitShapes();
     void selectFileAndExportLoopRange();
 
+    // Model loading ----------
+    LoadedModel buildModel(std::string filePath,
+                           BVHParserConfig parserConfig) const;
+    void startLoadingModel(const char *filePath);
+    void cancelLoadingModel();
+    void releaseCancelledLoadingModels(bool wait);
+    void swapLoadedModel();
+    void commitUploadedModel(bool wait = false);
+    bool isLoadingModel() const;
+    void unloadModel();
+
     // Update ----------
+    bool generateJointMatrices();
     void updateMatrices();
 
     // UI ----------
@@ -61,6 +109,7 @@ class App {
     void updateMainMenu();
     void updateAnimationControlWindow();
     void updateDebugWindow();
+    void updateLoadingWindow();
 
     // Glfw Callbacks ----------
     static void cursorPositionCallback(GLFWwindow *window, double xPos,
@@ -30,10 +30,21 @@ class UI {
                                                   "Y-Z-X", "Z-X-Y", "Z-Y-X"};
         int rotationOrderIndex = -1;
         bool exportAllPositionChannel = false;
+        // decode frames on demand instead of parsing the whole file
+        bool lazyMotionLoading = false;
+        // load only a part of frames
+        // *Num starts from 1 (user-friendly expression)
+        bool loadFrameRange = false;
+        int loadFirstFrameNum = 1;
+        int loadLastFrameNum = 1000;
+        int loadFrameStep = 1;
+        // compute joint matrices of all frames after loading
+        bool bakeJointMatrices = true;
     } config;
 
     bool showImGuiDemoWindow = false;
     bool showFloor = true;
     bool showAxisObject = false;
+    bool enableFrustumCulling = true;
     bool enableVsinc = true;
 };
@@ -1,12 +1,19 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <new>
+#include <system_error>
+#include <utility>
 
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../util/mappedFile.hpp"
 #include "./animator.hpp"
 #include "./bvhParser.hpp"
+#include "./eulerRotation.hpp"
+#include "./motionCache.hpp"
 
 // ----------------------------------------
 // Animator::Joint
@@ -32,6 +39,10 @@ void Animator::Joint::setClosestChildIDs(std::vector<ikura::GroupID> childIDs) {
 // Animator
 // ----------------------------------------
 
+// Forward declearation of helper functions ----------
+bool isWholeFileRequested(const BVHParserConfig &parserConfig);
+glm::vec3 getMotionPosition(const float *frameValues, ikura::GroupID jointID);
+
 void Animator::updateAnimator(float deltaTime) {
     if (animationStopped) {
         return;
@@ -56,32 +67,70 @@ void Animator::updateAnimator(float deltaTime) {
 
 Animator::Animator(std::shared_ptr<UI> ui) { this->ui = ui; }
 
-void Animator::initFromBVH(std::string filePath) {
-    BVHParser parser(filePath);
-    parser.parseBVH();
-    assert(parser.getSkentonData().size() <= ikura::NUM_OF_MODEL_MATRIX);
-
-    joints = parser.getSkentonData();
-    motion = parser.getMotion();
-    numOfFrames = motion->numOfFrames;
-    frameRate = motion->frameRate;
-
-    // set default rotation order for ui
-    {
-        std::string rotationOrderStr =
-            convertRotationAxisEnumToRotationOrderStr(motion->rotationOrder);
-
-        size_t arrSize = sizeof(ui->config.rotationOrderComboItems) /
-                         sizeof(ui->config.rotationOrderComboItems[0]);
+Animator::~Animator() { stopBakingJointMatrices(); }
+
+void Animator::initFromBVH(std::string filePath,
+                           BVHParserConfig parserConfig) {
+    stopBakingJointMatrices();
+    maxNumOfBakedBytes = 0;
+
+    MotionCacheData cacheData;
+    if (isMotionCacheFile(filePath)) {
+        // standalone motion cache file
+        if (!loadMotionCache(filePath, nullptr, cacheData)) {
+            std::string msg;
+            msg += "Unsupported version of motion cache file '";
+            msg += filePath;
+            msg += "'.";
+            throw std::runtime_error(msg);
+        }
+    } else if (MappedFile::isMappable(filePath) &&
+               isWholeFileRequested(parserConfig)) {
+        // reuse the cache of previously parsed .bvh file
+        MotionCacheKey cacheKey = createMotionCacheKey(filePath);
+        auto cacheFilePath = getMotionCacheFilePath(filePath);
+        try {
+            if (loadMotionCache(cacheFilePath, &cacheKey, cacheData)) {
+                touchMotionCache(cacheFilePath);
+            }
+        } catch (std::runtime_error &e) {
+            std::cerr << e.what() << std::endl;
+        }
 
-        for (size_t i = 0; i < arrSize; i++) {
-            if (strcmp(ui->config.rotationOrderComboItems[i],
-                       rotationOrderStr.c_str()) == 0) {
-                ui->config.rotationOrderIndex = i;
-                break;
+        if (!cacheData.motion) {
+            BVHParser parser(filePath, parserConfig);
+            parser.parseBVH();
+            cacheData.joints = parser.getSkentonData();
+            cacheData.motion = parser.getMotion();
+
+            // failing to write the cache does not prevent loading
+            // lazily decoded motion is not cached, it would decode all frames
+            try {
+                if (cacheData.motion->hasAllFrameValues() &&
+                    writeMotionCache(cacheFilePath, cacheKey, cacheData.joints,
+                                     *cacheData.motion,
+                                     parserConfig.progress.get())) {
+                    evictMotionCaches(MOTION_CACHE_DIRECTORY_MAX_BYTES,
+                                      cacheFilePath);
+                }
+            } catch (std::runtime_error &e) {
+                std::cerr << e.what() << std::endl;
             }
         }
+    } else {
+        BVHParser parser(filePath, parserConfig);
+        parser.parseBVH();
+        cacheData.joints = parser.getSkentonData();
+        cacheData.motion = parser.getMotion();
     }
+    assert(cacheData.joints.size() <= ikura::MAX_NUM_OF_MODEL_MATRIX);
+
+    joints = cacheData.joints;
+    motion = cacheData.motion;
+    buildJointHierarchy();
+    selectKernels();
+    numOfFrames = motion->numOfFrames;
+    frameRate = motion->frameRate;
 
     loopStartFrameIndex = 0;
     loopEndFrameIndex = numOfFrames - 1;
@@ -94,111 +143,269 @@ void Animator::initFromBVH(std::string filePath) {
     sourceFilePath = filePath;
 }
 
-void Animator::generateBones(
-    std::vector<std::shared_ptr<ikura::shapes::Shape>> &bones) {
-    assert(joints.size() <= ikura::NUM_OF_MODEL_MATRIX);
-    bones.clear();
-    bones.resize(joints.size());
+void Animator::updateUIRotationOrder() {
+    std::string rotationOrderStr =
+        convertRotationAxisEnumToRotationOrderStr(motion->rotationOrder);
+
+    size_t arrSize = sizeof(ui->config.rotationOrderComboItems) /
+                     sizeof(ui->config.rotationOrderComboItems[0]);
+
+    for (size_t i = 0; i < arrSize; i++) {
+        if (strcmp(ui->config.rotationOrderComboItems[i],
+                   rotationOrderStr.c_str()) == 0) {
+            ui->config.rotationOrderIndex = i;
+            break;
+        }
+    }
+}
+
+void Animator::generateBoneInstances(BoneInstances &instances) const {
+    assert(joints.size() <= ikura::MAX_NUM_OF_MODEL_MATRIX);
+    instances.rootJoints.clear();
+    instances.bones.clear();
+    instances.jointSpheres.clear();
 
-    uint32_t baseIndex = 0;
     for (ikura::GroupID id = 0; id < joints.size(); id++) {
         if (joints[id]->getParentIDs().empty()) {
             // Root Joint
-            bones[id] = std::make_shared<ikura::shapes::SingleColorCube>(
-                2.0, 2.0, 2.0, glm::vec3(0.0, 0.0, 0.0),
-                glm::vec3(1.0, 0.0, 0.0), id);
+            instances.rootJoints.emplace_back(id);
         } else {
             float length = glm::length(joints[id]->getPos());
-            bones[id] =
-                std::make_shared<ikura::shapes::OctahedronBone>(length, id);
+            instances.bones.emplace_back(id, glm::vec3(0.0), length);
+            // root and tip spheres
+            instances.jointSpheres.emplace_back(
+                id, glm::vec3(length, 0.0, 0.0), length * 0.03f);
+            instances.jointSpheres.emplace_back(id, glm::vec3(0.0),
+                                                length * 0.02f);
         }
-        bones[id]->setBaseIndex(baseIndex);
-        baseIndex += bones[id]->getVertices().size();
     }
 }
 
-std::array<glm::mat4, ikura::NUM_OF_MODEL_MATRIX>
-Animator::generateModelMatrices() {
-    uint32_t frameIndex = getCurrentFrameIndex();
-
-    // calculate current motion
-    std::vector<JointState> currentJointStates;
-    for (ikura::GroupID id = 0; id < joints.size(); id++) {
-        JointState js{};
-        js.pos = motion->jointMotions[id]->jointStates[frameIndex]->pos;
-        js.rot = motion->jointMotions[id]->jointStates[frameIndex]->rot;
-        currentJointStates.push_back(js);
-    }
-
-    // generate result matrices
-    std::array<glm::mat4, ikura::NUM_OF_MODEL_MATRIX> result;
+/**
+ * @brief Prepare the skeleton data used by generateModelMatrices().
+ *
+ * Joint IDs are assigned in depth-first order, so a parent always has a
+ * smaller ID than its children.
+ */
+void Animator::buildJointHierarchy() {
+    parentIndices.resize(joints.size());
+    boneAlignMatrices.resize(joints.size());
+    workspace.jointRotations.resize(joints.size());
+    workspace.jointWorldMatrices.resize(joints.size());
 
     for (ikura::GroupID id = 0; id < joints.size(); id++) {
-        result[id] = glm::mat4(1.0);
-        // convert "right-hand Y-up" to "right-hand Z-up"
-        result[id] *= glm::rotate(glm::mat4(1.0), glm::radians(90.0f),
-                                  glm::vec3(1.0, 0.0, 0.0));
-
         const std::vector<ikura::GroupID> &parentIDs =
             joints[id]->getParentIDs();
-
-        for (size_t parentIdx = 0; parentIdx < parentIDs.size(); parentIdx++) {
-            ikura::GroupID pID = parentIDs[parentIdx];
-            // Move to each parent's position
-            if (pID == 0) {
-                // Motion position
-                result[id] *=
-                    glm::translate(glm::mat4(1.0), currentJointStates[pID].pos);
-            } else {
-                // Joint offset
-                result[id] *=
-                    glm::translate(glm::mat4(1.0), joints[pID]->getPos());
-            }
-
-            // Motion rotation
-            const auto multiplyRotateMat = [&](RotationAxisEnum axis) {
-                glm::vec3 axisVec3;
-                float radians;
-                switch (axis) {
-                case RotationAxisEnum::X:
-                    radians = glm::radians(currentJointStates[pID].rot.x);
-                    axisVec3 = glm::vec3(1.0, 0.0, 0.0);
-                    break;
-                case RotationAxisEnum::Y:
-                    radians = glm::radians(currentJointStates[pID].rot.y);
-                    axisVec3 = glm::vec3(0.0, 1.0, 0.0);
-                    break;
-                case RotationAxisEnum::Z:
-                    radians = glm::radians(currentJointStates[pID].rot.z);
-                    axisVec3 = glm::vec3(0.0, 0.0, 1.0);
-                    break;
-                }
-                result[id] *= glm::rotate(glm::mat4(1.0), radians, axisVec3);
-            };
-            std::for_each(motion->rotationOrder.begin(),
-                          motion->rotationOrder.end(), multiplyRotateMat);
-        }
-
-        // Move to current joint's position
-        result[id] *= glm::translate(glm::mat4(1.0),
-                                     id != 0 ? joints[id]->getPos()
-                                             : currentJointStates[id].pos);
+        parentIndices[id] = parentIDs.empty() ? -1 : parentIDs.back();
+        assert(parentIndices[id] < static_cast<int32_t>(id));
+        // only the root (ID 0) has no parent
+        assert((id == 0) == (parentIndices[id] < 0));
 
         // rotate current joint object to turn to parent
+        boneAlignMatrices[id] = glm::mat4(1.0);
         glm::vec3 pos = glm::normalize(joints[id]->getPos());
         glm::vec3 orig = glm::vec3(1.0, 0.0, 0.0);
         glm::vec3 cross = glm::normalize(glm::cross(pos, orig));
         if (glm::length(cross) > 0) {
-            result[id] *= glm::rotate(
+            boneAlignMatrices[id] = glm::rotate(
                 glm::mat4(1.0),
                 glm::pi<float>() - glm::acos(glm::dot(pos, orig)), cross);
         } else if (pos.x > 0) {
-            result[id] *= glm::rotate(glm::mat4(1.0), glm::radians(180.0f),
-                                      glm::vec3(0.0, 1.0, 0.0));
+            boneAlignMatrices[id] =
+                glm::rotate(glm::mat4(1.0), glm::radians(180.0f),
+                            glm::vec3(0.0, 1.0, 0.0));
         }
     }
+}
 
-    return result;
+/**
+ * @brief Select the kernels used by generateModelMatrices().
+ *
+ * The rotation order and the channel layout do not change between frames,
+ * so the per-joint loop is specialized for them instead of checking them for
+ * each joint.
+ */
+void Animator::selectKernels() {
+    eulerRotationKernel = selectEulerRotationKernel(motion->rotationOrder);
+
+    bool allJointsHavePosition = true;
+    for (ikura::GroupID id = 0; id < joints.size(); id++) {
+        if (joints[id]->getIsEdge()) {
+            continue;
+        }
+        const std::set<ChannelEnum> &channels = motion->ownedChannels[id];
+        if (channels.count(ChannelEnum::Xposition) == 0 ||
+            channels.count(ChannelEnum::Yposition) == 0 ||
+            channels.count(ChannelEnum::Zposition) == 0) {
+            allJointsHavePosition = false;
+            break;
+        }
+    }
+
+    if (allJointsHavePosition) {
+        jointMatricesKernel =
+            &Animator::computeJointMatrices<PositionChannelLayout::AllJoints>;
+    } else {
+        jointMatricesKernel =
+            &Animator::computeJointMatrices<PositionChannelLayout::RootOnly>;
+    }
+}
+
+void Animator::generateModelMatrices(glm::mat4 *modelMatrices) {
+    uint32_t frameIndex = getCurrentFrameIndex();
+
+    if (isJointMatricesBaked()) {
+        const glm::mat4 *matrices =
+            bakedMatrices.data() + frameIndex * joints.size();
+        std::copy(matrices, matrices + joints.size(), modelMatrices);
+        return;
+    }
+
+    const float *frameValues =
+        std::as_const(*motion).getFrameValues(frameIndex);
+    (this->*jointMatricesKernel)(frameValues, workspace, modelMatrices);
+}
+
+template <Animator::PositionChannelLayout layout>
+void Animator::computeJointMatrices(const float *frameValues,
+                                    JointMatricesWorkspace &workspace,
+                                    glm::mat4 *result) const {
+    std::vector<glm::mat3> &jointRotations = workspace.jointRotations;
+    std::vector<glm::mat4> &jointWorldMatrices = workspace.jointWorldMatrices;
+
+    // rotations of all joints in one pass
+    eulerRotationKernel(frameValues, joints.size(), jointRotations.data());
+
+    // convert "right-hand Y-up" to "right-hand Z-up"
+    const glm::mat4 rootParentMatrix = glm::rotate(
+        glm::mat4(1.0), glm::radians(90.0f), glm::vec3(1.0, 0.0, 0.0));
+
+    // Root joint, moved to the motion position
+    glm::mat4 rootMatrix =
+        glm::translate(rootParentMatrix, getMotionPosition(frameValues, 0));
+    result[0] = rootMatrix * boneAlignMatrices[0];
+    jointWorldMatrices[0] = rootMatrix * glm::mat4(jointRotations[0]);
+
+    // parents are visited before children, so each joint reuses the world
+    // matrix of its parent
+    for (ikura::GroupID id = 1; id < joints.size(); id++) {
+        const glm::mat4 &parentMatrix = jointWorldMatrices[parentIndices[id]];
+
+        if (joints[id]->getIsEdge()) {
+            // End Site has no channels and no children
+            result[id] = glm::translate(parentMatrix, joints[id]->getPos()) *
+                         boneAlignMatrices[id];
+            continue;
+        }
+
+        // Move to current joint's position
+        glm::mat4 jointMatrix;
+        if constexpr (layout == PositionChannelLayout::AllJoints) {
+            jointMatrix = glm::translate(parentMatrix,
+                                         getMotionPosition(frameValues, id));
+        } else {
+            jointMatrix = glm::translate(parentMatrix, joints[id]->getPos());
+        }
+        result[id] = jointMatrix * boneAlignMatrices[id];
+
+        // Motion rotation
+        jointWorldMatrices[id] = jointMatrix * glm::mat4(jointRotations[id]);
+    }
+}
+
+/**
+ * @brief Start baking joint matrices of all frames on a background thread.
+ *
+ * Frames are played with live FK until baking finishes. Baking is redone
+ * with the same limit when the rotation order changes.
+ */
+void Animator::startBakingJointMatrices(size_t maxNumOfBakedBytes) {
+    stopBakingJointMatrices();
+    this->maxNumOfBakedBytes = maxNumOfBakedBytes;
+
+    // lazily decoded frame values cannot be read from several threads
+    if (!motion->hasAllFrameValues()) {
+        return;
+    }
+    const size_t numOfMatrices = size_t(numOfFrames) * joints.size();
+    if (numOfMatrices * sizeof(glm::mat4) > maxNumOfBakedBytes) {
+        return;
+    }
+
+    bakeCancelRequested = false;
+    try {
+        bakeThread = std::thread(&Animator::bakeJointMatrices, this);
+    } catch (const std::system_error &) {
+        // play with live FK
+    }
+}
+
+bool Animator::isJointMatricesBaked() const { return bakeFinished.load(); }
+
+/// Body of the bake thread. Frames are split into chunks for worker threads.
+void Animator::bakeJointMatrices() {
+    const uint32_t numOfThreads =
+        std::min(std::max(std::thread::hardware_concurrency(), 1U),
+                 std::max(numOfFrames, 1U));
+    const uint32_t numOfFramesPerThread =
+        (numOfFrames + numOfThreads - 1) / numOfThreads;
+
+    std::vector<std::thread> workers;
+    try {
+        bakedMatrices.resize(size_t(numOfFrames) * joints.size());
+        workers.reserve(numOfThreads);
+    } catch (const std::bad_alloc &) {
+        // play with live FK
+        return;
+    }
+
+    for (uint32_t threadIndex = 0; threadIndex < numOfThreads; threadIndex++) {
+        const uint32_t firstFrame = threadIndex * numOfFramesPerThread;
+        const uint32_t endFrame =
+            std::min(firstFrame + numOfFramesPerThread, numOfFrames);
+
+        auto bakeFrames = [this, firstFrame, endFrame]() {
+            JointMatricesWorkspace workerWorkspace;
+            workerWorkspace.jointRotations.resize(joints.size());
+            workerWorkspace.jointWorldMatrices.resize(joints.size());
+
+            const Motion &constMotion = *motion;
+            for (uint32_t frame = firstFrame; frame < endFrame; frame++) {
+                if (bakeCancelRequested.load()) {
+                    return;
+                }
+                (this->*jointMatricesKernel)(
+                    constMotion.getFrameValues(frame), workerWorkspace,
+                    bakedMatrices.data() + size_t(frame) * joints.size());
+            }
+        };
+
+        try {
+            workers.emplace_back(bakeFrames);
+        } catch (const std::system_error &) {
+            // stop the started workers and play with live FK
+            bakeCancelRequested = true;
+            break;
+        }
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (!bakeCancelRequested.load()) {
+        bakeFinished = true;
+    }
+}
+
+/// Cancel baking, wait for the bake thread and drop baked matrices.
+void Animator::stopBakingJointMatrices() {
+    bakeCancelRequested = true;
+    if (bakeThread.joinable()) {
+        bakeThread.join();
+    }
+    bakeFinished = false;
+    bakedMatrices.clear();
+    bakedMatrices.shrink_to_fit();
 }
 
 uint32_t Animator::getNumOfJoints() const { return joints.size(); }
@@ -207,6 +414,14 @@ uint32_t Animator::getNumOfFrames() const { return numOfFrames; }
 
 float Animator::getFrameRate() const { return frameRate; }
 
+uint32_t Animator::getNumOfSourceFrames() const {
+    return motion->numOfSourceFrames;
+}
+
+uint32_t Animator::getSourceFrameIndex(uint32_t frameIndex) const {
+    return motion->getSourceFrameIndex(frameIndex);
+}
+
 uint32_t Animator::getLoopStartFrameIndex() const {
     return loopStartFrameIndex;
 }
@@ -234,7 +449,13 @@ const std::vector<ikura::GroupID> &Animator::Joint::getClosestChildIDs() const {
 
 void Animator::setRotationOrder(std::array<RotationAxisEnum, 3> rotationOrder) {
     std::cout << "aaa";
+    // baked matrices are computed with the previous rotation order
+    stopBakingJointMatrices();
     motion->rotationOrder = rotationOrder;
+    selectKernels();
+    if (maxNumOfBakedBytes > 0) {
+        startBakingJointMatrices(maxNumOfBakedBytes);
+    }
 }
 
 bool Animator::isAnimationStopped() const { return animationStopped; }
@@ -313,20 +534,27 @@ void Animator::showMotionInfo() {
     for (uint32_t frame = 0; frame < numOfFrames; frame++) {
         std::cout << "frame:" << frame << std::endl;
         for (uint32_t joint = 0; joint < joints.size(); joint++) {
-            std::cout << "(("
-                      << motion->jointMotions[joint]->jointStates[frame]->pos.x
-                      << ","
-                      << motion->jointMotions[joint]->jointStates[frame]->pos.y
-                      << ","
-                      << motion->jointMotions[joint]->jointStates[frame]->pos.z
-                      << "), ("
-                      << motion->jointMotions[joint]->jointStates[frame]->rot.x
-                      << ","
-                      << motion->jointMotions[joint]->jointStates[frame]->rot.y
-                      << ","
-                      << motion->jointMotions[joint]->jointStates[frame]->rot.z
-                      << ")), " << std::ends;
+            auto js = motion->getJointState(frame, joint);
+            std::cout << "((" << js.pos.x << "," << js.pos.y << "," << js.pos.z
+                      << "), (" << js.rot.x << "," << js.rot.y << ","
+                      << js.rot.z << ")), " << std::ends;
         }
         std::cout << std::endl;
     }
 }
+
+/// Return true if `parserConfig` loads all frames of the file.
+/// Motion caches hold all frames, so only such loads use them.
+bool isWholeFileRequested(const BVHParserConfig &parserConfig) {
+    return parserConfig.firstFrame == 0 &&
+           parserConfig.lastFrame == std::numeric_limits<size_t>::max() &&
+           parserConfig.frameStep <= 1;
+}
+
+/// Position channels of `jointID` in a frame.
+glm::vec3 getMotionPosition(const float *frameValues, ikura::GroupID jointID) {
+    const float *values = frameValues + Motion::getJointOffset(jointID);
+    return glm::vec3(values[ChannelEnum::Xposition],
+                     values[ChannelEnum::Yposition],
+                     values[ChannelEnum::Zposition]);
+}
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <fstream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -12,10 +14,14 @@
 #include <ikura/ikura.hpp>
 
 #include "../context/ui.hpp"
+#include "./bvhParserConfig.hpp"
 #include "./common.hpp"
+#include "./eulerRotation.hpp"
 
 #define MAX_ANIMATION_SPEED 10.0f
 #define MIN_ANIMATION_SPEED (1.0f / 128.0f)
+// Takes needing more memory than this to bake are played with live FK
+#define MAX_BAKED_JOINT_MATRICES_BYTES ((size_t)512 * 1024 * 1024)
 
 class Animator {
     std::shared_ptr<Motion> motion;
@@ -68,16 +74,40 @@ class Animator {
     };
 
     Animator(std::shared_ptr<UI> ui);
-
-    void initFromBVH(std::string filePath);
-    void
-    generateBones(std::vector<std::shared_ptr<ikura::shapes::Shape>> &bones);
-    std::array<glm::mat4, ikura::NUM_OF_MODEL_MATRIX> generateModelMatrices();
+    ~Animator();
+
+    /// Can be called on a thread other than the UI thread.
+    void initFromBVH(std::string filePath, BVHParserConfig parserConfig = {});
+    /// Select the rotation order of the loaded motion in the UI.
+    void updateUIRotationOrder();
+    /// Instances of the unit meshes drawing the skeleton. GroupID of the
+    /// meshes must be 0.
+    struct BoneInstances {
+        // 2x2x2 cube at the root joint
+        std::vector<ikura::BasicInstance> rootJoints;
+        // bone of length 1, from (1, 0, 0) to the origin
+        std::vector<ikura::BasicInstance> bones;
+        // sphere of radius 1 at both ends of the bones
+        std::vector<ikura::BasicInstance> jointSpheres;
+    };
+    void generateBoneInstances(BoneInstances &instances) const;
+    /// Write model matrices of all joints to `modelMatrices`, [GroupID].
+    void generateModelMatrices(glm::mat4 *modelMatrices);
+    /// Compute joint matrices of all frames on background threads, so that
+    /// generateModelMatrices() only looks them up. Does nothing if they take
+    /// more than `maxNumOfBakedBytes` or frames are decoded lazily.
+    void startBakingJointMatrices(
+        size_t maxNumOfBakedBytes = MAX_BAKED_JOINT_MATRICES_BYTES);
+    bool isJointMatricesBaked() const;
     void updateAnimator(float deltaTime);
 
     uint32_t getNumOfJoints() const;
     uint32_t getNumOfFrames() const;
     float getFrameRate() const;
+    /// Number of frames in the source file, including frames not loaded.
+    uint32_t getNumOfSourceFrames() const;
+    /// Frame index in the source file of loaded frame `frameIndex`.
+    uint32_t getSourceFrameIndex(uint32_t frameIndex) const;
     uint32_t getLoopStartFrameIndex() const;
     uint32_t getLoopEndFrameIndex() const;
     uint32_t getCurrentFrameIndex() const;
@@ -107,5 +137,54 @@ class Animator {
     void showMotionInfo();
 
   private:
+    /// Source of the translation of joints, fixed per file.
+    enum class PositionChannelLayout {
+        /// Only the root has position channels, other joints use offsets.
+        RootOnly,
+        /// Every joint except End Sites has position channels.
+        AllJoints
+    };
+    /// Per-joint values of a frame used while computing joint matrices.
+    struct JointMatricesWorkspace {
+        // Motion rotation of each joint
+        std::vector<glm::mat3> jointRotations;
+        // World matrix of each joint, reused by children
+        std::vector<glm::mat4> jointWorldMatrices;
+    };
+    typedef void (Animator::*JointMatricesKernel)(
+        const float *frameValues, JointMatricesWorkspace &workspace,
+        glm::mat4 *result) const;
+
+    void buildJointHierarchy();
+    /// Select the kernels for the rotation order and channel layout of the
+    /// motion. Called again when the rotation order changes.
+    void selectKernels();
+    /// Write matrices of all joints in a frame to `result`.
+    template <PositionChannelLayout layout>
+    void computeJointMatrices(const float *frameValues,
+                              JointMatricesWorkspace &workspace,
+                              glm::mat4 *result) const;
+    void bakeJointMatrices();
+    void stopBakingJointMatrices();
+
     std::vector<std::shared_ptr<Animator::Joint>> joints;
+
+    // Parent of each joint, -1 for the root. Parents come before children.
+    std::vector<int32_t> parentIndices;
+    // Rotation turning each bone to its parent, depends only on the skeleton
+    std::vector<glm::mat4> boneAlignMatrices;
+    // Used by live FK of the current frame
+    JointMatricesWorkspace workspace;
+
+    EulerRotationKernel eulerRotationKernel = nullptr;
+    JointMatricesKernel jointMatricesKernel = nullptr;
+
+    // Joint matrices of all frames, [frame * joints.size() + jointID]
+    // Read only after bakeFinished becomes true.
+    std::vector<glm::mat4> bakedMatrices;
+    // 0 if baking is not requested
+    size_t maxNumOfBakedBytes = 0;
+    std::thread bakeThread;
+    std::atomic<bool> bakeFinished{false};
+    std::atomic<bool> bakeCancelRequested{false};
 };
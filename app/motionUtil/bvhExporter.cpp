@@ -51,45 +51,17 @@ void exportLoopRangeToBvhFile(const std::shared_ptr<Animator> animator,
             }
 
             auto id = motion->channelDescriptionOrder[i].joindId;
+            auto channel = motion->channelDescriptionOrder[i].channel;
             bool exportPositionChannelValue = false;
             if (id == 0 || exportAllPositionChennel) {
                 exportPositionChannelValue = true;
             }
 
-            switch (motion->channelDescriptionOrder[i].channel) {
-            case ChannelEnum::Xposition:
-                if (exportPositionChannelValue) {
-                    targetFile << motion->jointMotions[id]
-                                      ->jointStates[frameIdx]
-                                      ->pos.x;
-                }
-                break;
-            case ChannelEnum::Yposition:
-                if (exportPositionChannelValue) {
-                    targetFile << motion->jointMotions[id]
-                                      ->jointStates[frameIdx]
-                                      ->pos.y;
-                }
-                break;
-            case ChannelEnum::Zposition:
-                if (exportPositionChannelValue) {
-                    targetFile << motion->jointMotions[id]
-                                      ->jointStates[frameIdx]
-                                      ->pos.z;
-                }
-                break;
-            case ChannelEnum::Xrotation:
-                targetFile
-                    << motion->jointMotions[id]->jointStates[frameIdx]->rot.x;
-                break;
-            case ChannelEnum::Yrotation:
-                targetFile
-                    << motion->jointMotions[id]->jointStates[frameIdx]->rot.y;
-                break;
-            case ChannelEnum::Zrotation:
-                targetFile
-                    << motion->jointMotions[id]->jointStates[frameIdx]->rot.z;
-                break;
+            bool isPositionChannel = (channel == ChannelEnum::Xposition ||
+                                      channel == ChannelEnum::Yposition ||
+                                      channel == ChannelEnum::Zposition);
+            if (!isPositionChannel || exportPositionChannelValue) {
+                targetFile << motion->getChannelValue(frameIdx, id, channel);
             }
         }
 
@@ -104,7 +76,7 @@ void writeJointsRecursive(std::vector<std::shared_ptr<Animator::Joint>> joints,
                           bool writeAllPositionChannels) {
 
     auto currentJoint = joints[currentJointID];
-    auto jointMotion = motion->jointMotions[currentJointID];
+    const auto &ownedChannels = motion->ownedChannels[currentJointID];
 
     // Joint Name
     std::string jointDeclaration;
@@ -137,9 +109,9 @@ void writeJointsRecursive(std::vector<std::shared_ptr<Animator::Joint>> joints,
         // true
         std::set<ChannelEnum> channelsToExport;
         if (currentJointID == 0 || writeAllPositionChannels) {
-            channelsToExport = jointMotion->ownedChannels;
+            channelsToExport = ownedChannels;
         } else {
-            channelsToExport = jointMotion->ownedChannels;
+            channelsToExport = ownedChannels;
             channelsToExport.erase(ChannelEnum::Xposition);
             channelsToExport.erase(ChannelEnum::Yposition);
             channelsToExport.erase(ChannelEnum::Zposition);
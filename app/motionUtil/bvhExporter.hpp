@@ -4,6 +4,7 @@
 
 #include "./animator.hpp"
 
+/// Throws parse_failed_error if a frame of lazily decoded motion is invalid.
 void exportLoopRangeToBvhFile(const std::shared_ptr<Animator> animator,
                               std::filesystem::path destFile,
                               bool exportAllPositionChennel);
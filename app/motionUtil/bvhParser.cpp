@@ -1,23 +1,45 @@
 #include "./bvhParser.hpp"
 
 #include <algorithm>
-#include <fstream>
+#include <atomic>
+#include <cstring>
+#include <exception>
 #include <iostream>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
 
+#include "../util/numberParser.hpp"
+
+// Frame count below which spawning worker threads does not pay off
+#define MIN_NUM_OF_FRAMES_FOR_PARALLEL_PARSING 1024
+// Frames between progress reports / cancellation checks
+#define NUM_OF_FRAMES_PER_PROGRESS_REPORT 256
+
 // Forward declearation of helper functions ----------
-bool isValidChannel(std::string str);
+bool isValidChannel(std::string_view str);
+bool convertTokenToFloat(std::string_view token, float &value);
+bool convertTokenToSize(std::string_view token, size_t &value);
+std::string_view readFrameLine(const char *&cursor, const char *end);
+void skipFrameLines(const char *&cursor, const char *end,
+                    uint32_t numOfLines);
+void decodeFrameLine(std::string_view line, uint32_t lineNum,
+                     const std::vector<uint32_t> &channelWritePlan,
+                     float *frameValues);
+void checkNumOfFrameLineValues(std::string_view line, uint32_t lineNum,
+                               size_t numOfChannels);
 
 void BVHParser::parseJoints(bool isJointTokenRead,
                             ClosestChildMap &closestChildMap) {
-    std::string input, jointName;
-    uint32_t numOfChannels;
+    std::string_view input;
+    std::string jointName;
+    size_t numOfChannels;
     glm::vec3 pos;
     bool isRoot = false;
     bool isEndSite = false;
@@ -32,7 +54,7 @@ void BVHParser::parseJoints(bool isJointTokenRead,
         msg += filePath;
         msg += "'.\n";
         msg += "The max number of Joints in ikura is: ";
-        msg += std::to_string(ikura::NUM_OF_MODEL_MATRIX);
+        msg += std::to_string(ikura::MAX_NUM_OF_MODEL_MATRIX);
         msg += ".";
 
         throw std::runtime_error(msg);
@@ -40,14 +62,14 @@ void BVHParser::parseJoints(bool isJointTokenRead,
 
     // Root / Joint / End Site definition
     if (!isJointTokenRead) {
-        *inputStream >> input;
+        input = tokenizer->next();
         bool isInvalidToken = false;
         if (isRootDefined) {
             if (input == TOKEN_ROOT) {
                 throw parse_failed_error("Multiple Root definition detected.",
-                                         inputStream);
+                                         *tokenizer);
             } else if (input == TOKEN_END_SITE_END) {
-                *inputStream >> input;
+                input = tokenizer->next();
                 if (input == TOKEN_END_SITE_SITE) {
                     isEndSite = true;
                 } else {
@@ -61,7 +83,7 @@ void BVHParser::parseJoints(bool isJointTokenRead,
                 isRootDefined = true;
                 isRoot = true;
             } else if (input == TOKEN_JOINT || input == TOKEN_END_SITE_END) {
-                throw parse_failed_error("Root is not defined.", inputStream);
+                throw parse_failed_error("Root is not defined.", *tokenizer);
             } else {
                 isInvalidToken = true;
             }
@@ -76,78 +98,83 @@ void BVHParser::parseJoints(bool isJointTokenRead,
             msg += "' or '";
             msg += TOKEN_END_SITE;
             msg += "' are expected.";
-            throw parse_failed_error(msg, inputStream);
+            throw parse_failed_error(msg, *tokenizer);
         }
     }
 
     // joint name
     if (!isEndSite) {
-        *inputStream >> jointName;
+        jointName = tokenizer->next();
     }
 
     // Beggin bracket
-    *inputStream >> input;
+    input = tokenizer->next();
     if (input != TOKEN_BEGGIN_BRACKET) {
-        throw parse_failed_error("Beggin bracket is expected.", inputStream);
+        throw parse_failed_error("Beggin bracket is expected.", *tokenizer);
     }
 
     // Offset token
-    *inputStream >> input;
+    input = tokenizer->next();
     if (input != TOKEN_OFFSET) {
         std::string msg;
         msg += "'";
         msg += TOKEN_OFFSET;
         msg += "' is expected.";
-        throw parse_failed_error(msg, inputStream);
+        throw parse_failed_error(msg, *tokenizer);
     }
 
     // offset values
-    try {
-        *inputStream >> pos.x >> pos.y >> pos.z;
-    } catch (std::exception e) {
-        throw parse_failed_error(
-            "Invalid Position format. 3 position value are expected.",
-            inputStream);
+    for (int axis = 0; axis < 3; axis++) {
+        if (!convertTokenToFloat(tokenizer->next(), pos[axis])) {
+            throw parse_failed_error(
+                "Invalid Position format. 3 position value are expected.",
+                *tokenizer);
+        }
     }
 
     if (!isEndSite) {
         // Channels token
-        *inputStream >> input;
+        input = tokenizer->next();
         if (input != TOKEN_CHANNELS) {
             std::string msg;
             msg += "'";
             msg += TOKEN_CHANNELS;
             msg += "' is expected.";
-            throw parse_failed_error(msg, inputStream);
+            throw parse_failed_error(msg, *tokenizer);
         }
 
         // number of channels
-        try {
-            *inputStream >> numOfChannels;
-        } catch (std::exception e) {
-            std::string msg;
+        if (!convertTokenToSize(tokenizer->next(), numOfChannels)) {
             throw parse_failed_error(
-                "Number of channels (int value) is expected.", inputStream);
+                "Number of channels (int value) is expected.", *tokenizer);
         }
 
         // register channels
-        for (uint32_t i = 0; i < numOfChannels; i++) {
-            *inputStream >> input;
+        for (size_t i = 0; i < numOfChannels; i++) {
+            input = tokenizer->next();
             if (!isValidChannel(input)) {
                 std::string msg;
                 msg += "Invalid Channel name at #";
-                msg += i;
+                msg += std::to_string(i);
                 msg += ".";
-                throw parse_failed_error(msg, inputStream);
+                throw parse_failed_error(msg, *tokenizer);
             }
 
-            auto channel = convertStrToChannelEnum(input);
+            auto channel = convertStrToChannelEnum(std::string(input));
 
             ChannelJointCorrespondance correspondance{};
             correspondance.joindId = currentID;
             correspondance.channel = channel;
             motion->channelDescriptionOrder.push_back(correspondance);
 
+            // channels owned by the joint and where its values are stored
+            if (motion->ownedChannels.size() <= currentID) {
+                motion->ownedChannels.resize(currentID + 1);
+            }
+            motion->ownedChannels[currentID].insert(channel);
+            channelWritePlan.push_back(static_cast<uint32_t>(
+                Motion::getJointOffset(currentID) + channel));
+
             // Perdict rotation order
             if (!rotationOrderPredicted) {
                 RotationAxisEnum rotation;
@@ -165,7 +192,7 @@ void BVHParser::parseJoints(bool isJointTokenRead,
         }
 
         currentID++;
-        if (currentID > ikura::NUM_OF_MODEL_MATRIX) {
+        if (currentID > ikura::MAX_NUM_OF_MODEL_MATRIX) {
             throwTooManyJointsError();
         }
         parseJoints(false, closestChildMap);
@@ -173,21 +200,21 @@ void BVHParser::parseJoints(bool isJointTokenRead,
 
     // End bracket / Joint token
     while (true) {
-        *inputStream >> input;
+        input = tokenizer->next();
         if (input == TOKEN_JOINT) {
             currentID++;
-            if (currentID > ikura::NUM_OF_MODEL_MATRIX) {
+            if (currentID > ikura::MAX_NUM_OF_MODEL_MATRIX) {
                 throwTooManyJointsError();
             }
             parseJoints(true, closestChildMap);
-        } else if (input == TOKEN_END_BRACKET && !inputStream->eof()) {
+        } else if (input == TOKEN_END_BRACKET) {
             break;
         } else {
             std::string msg;
             msg += "End bracket or '";
             msg += TOKEN_JOINT;
             msg += "' are expected.";
-            throw parse_failed_error(msg, inputStream);
+            throw parse_failed_error(msg, *tokenizer);
         }
     }
 
@@ -207,184 +234,545 @@ void BVHParser::parseJoints(bool isJointTokenRead,
 }
 
 void BVHParser::parseMotion() {
-    std::string input;
+    std::string_view input;
 
     // Frames: token
-    *inputStream >> input;
+    input = tokenizer->next();
     if (input != TOKEN_FRAMES) {
         std::string msg;
         msg += "'";
         msg += TOKEN_FRAMES;
         msg += "' is expected";
-        throw parse_failed_error(msg, inputStream);
+        throw parse_failed_error(msg, *tokenizer);
     }
 
     // frames value
-    try {
-        *inputStream >> motion->numOfFrames;
-    } catch (std::exception e) {
+    if (!convertTokenToSize(tokenizer->next(), motion->numOfFrames)) {
         throw parse_failed_error("Number of frames (int value) is expected.",
-                                 inputStream);
+                                 *tokenizer);
     }
-
-    // allocate JointMotions
-    for (size_t jointIdx = 0; jointIdx < skelton.size(); jointIdx++) {
-        // auto jm = std::make_shared<JointMotion>();
-        motion->jointMotions.push_back(std::make_shared<JointMotion>());
+    selectFramesToLoad();
+    if (config.progress) {
+        config.progress->numOfTotalFrames = motion->numOfFrames;
     }
 
     // Frame Time: token
-    *inputStream >> input;
+    input = tokenizer->next();
     if (input != TOKEN_FRAME_TIME_FRAME) {
         std::string msg;
         msg += "'";
         msg += TOKEN_FRAME_TIME;
         msg += "' is expected.";
-        throw parse_failed_error(msg, inputStream);
+        throw parse_failed_error(msg, *tokenizer);
     }
-    *inputStream >> input;
+    input = tokenizer->next();
     if (input != TOKEN_FRAME_TIME_TIME) {
         std::string msg;
         msg += "'";
         msg += TOKEN_FRAME_TIME;
         msg += "' is expected.";
-        throw parse_failed_error(msg, inputStream);
+        throw parse_failed_error(msg, *tokenizer);
     }
 
     // frame time value
-    try {
-        *inputStream >> motion->frameRate;
-    } catch (std::exception e) {
+    if (!convertTokenToFloat(tokenizer->next(), motion->frameRate)) {
         throw parse_failed_error("Frame rate (float value) is expected.",
-                                 inputStream);
+                                 *tokenizer);
     }
+    // the time between loaded frames
+    motion->frameRate *= motion->sourceFrameStep;
     // flush new line
-    std::getline(*inputStream, input);
+    tokenizer->nextLine();
+
+    // End Sites own no channels
+    motion->ownedChannels.resize(skelton.size());
+
+    // only index frame lines, frames are decoded when accessed
+    if (config.lazyMotionDecoding) {
+        auto chunks = splitMotionIntoChunks(
+            std::max(config.numOfFramesPerFrameIndex, 1U), true);
+        auto frameDecoder = std::make_shared<BVHFrameDecoder>(
+            tokenizer, chunks, channelWritePlan, skelton.size());
+        motion->attachFrameDecoder(frameDecoder, skelton.size(),
+                                   motion->numOfFrames,
+                                   config.maxNumOfDecodedChunks);
+        return;
+    }
 
-    std::stringstream strStream;
-    uint32_t numOfChannels =
-        static_cast<uint32_t>(motion->channelDescriptionOrder.size());
-    float value;
-    for (uint32_t frame = 0; frame < motion->numOfFrames; frame++) {
-        strStream.clear();
-        std::getline(*inputStream, input);
-        if (frame < motion->numOfFrames - 1 && inputStream->eof()) {
+    // split frame lines into chunks for each worker thread
+    uint32_t numOfThreads = 1;
+    if (config.parallelMotionParsing &&
+        motion->numOfFrames >= MIN_NUM_OF_FRAMES_FOR_PARALLEL_PARSING) {
+        numOfThreads = config.numOfWorkerThreads > 0
+                           ? config.numOfWorkerThreads
+                           : std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    auto chunks = splitMotionIntoChunks(
+        (motion->numOfFrames + numOfThreads - 1) / numOfThreads);
+
+    // allocate values of all frames at once (filled by decodeMotionChunk)
+    motion->allocateFrames(skelton.size(), motion->numOfFrames);
+
+    if (chunks.size() == 1) {
+        decodeMotionChunk(chunks[0]);
+        return;
+    }
+
+    // decode chunks on worker threads
+    // the error of the earliest chunk is reported as in serial parsing
+    std::vector<std::exception_ptr> errors(chunks.size());
+    std::atomic<size_t> firstFailedChunkIndex = chunks.size();
+    auto decodeChunk = [&](size_t chunkIndex) {
+        // skip if an earlier chunk has already failed
+        if (firstFailedChunkIndex.load() < chunkIndex) {
+            return;
+        }
+
+        try {
+            decodeMotionChunk(chunks[chunkIndex]);
+        } catch (...) {
+            errors[chunkIndex] = std::current_exception();
+
+            size_t expected = firstFailedChunkIndex.load();
+            while (chunkIndex < expected &&
+                   !firstFailedChunkIndex.compare_exchange_weak(
+                       expected, chunkIndex)) {
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (size_t chunkIndex = 0; chunkIndex < chunks.size(); chunkIndex++) {
+        try {
+            workers.emplace_back(decodeChunk, chunkIndex);
+        } catch (const std::system_error &) {
+            // no more threads can be started,
+            // decode the rest on this thread
+            for (; chunkIndex < chunks.size(); chunkIndex++) {
+                decodeChunk(chunkIndex);
+            }
+        }
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    if (firstFailedChunkIndex.load() < chunks.size()) {
+        std::rethrow_exception(errors[firstFailedChunkIndex.load()]);
+    }
+}
+
+/**
+ * @brief Select frames to load from BVHParserConfig.
+ *
+ * `motion->numOfFrames` is the number of frames in the file when called, and
+ * becomes the number of frames to load.
+ */
+void BVHParser::selectFramesToLoad() {
+    const size_t numOfSourceFrames = motion->numOfFrames;
+    motion->numOfSourceFrames = numOfSourceFrames;
+    motion->sourceFirstFrame = config.firstFrame;
+    motion->sourceFrameStep = std::max<size_t>(config.frameStep, 1);
+
+    if (numOfSourceFrames == 0) {
+        motion->sourceFirstFrame = 0;
+        return;
+    }
+
+    const size_t lastFrame = std::min(config.lastFrame, numOfSourceFrames - 1);
+    if (config.firstFrame > lastFrame) {
+        std::string msg;
+        msg += "The first frame to load (";
+        msg += std::to_string(config.firstFrame);
+        msg += ") is out of the frames in '";
+        msg += filePath;
+        msg += "' (0 - ";
+        msg += std::to_string(lastFrame);
+        msg += ").";
+        throw std::runtime_error(msg);
+    }
+
+    motion->numOfFrames =
+        (lastFrame - config.firstFrame) / motion->sourceFrameStep + 1;
+}
+
+/**
+ * @brief Split frame lines to load into chunks of `numOfFramesPerChunk`
+ * frames.
+ *
+ * Only line breaks are scanned here, values are decoded later by
+ * decodeMotionChunk() or BVHFrameDecoder.
+ * Lines after the last frame to load are not scanned.
+ *
+ * @param checkNumOfValues if true, lines of frames to load are checked to
+ * have as many values as channels, so that a lazily decoded file with
+ * missing or extra values is rejected while loading.
+ */
+std::vector<BVHMotionChunk>
+BVHParser::splitMotionIntoChunks(size_t numOfFramesPerChunk,
+                                 bool checkNumOfValues) {
+    const auto remaining = tokenizer->getRemaining();
+    const char *p = remaining.data();
+    const char *const end = p + remaining.size();
+    const uint32_t firstLineNum = tokenizer->getCurrentLineNum();
+
+    const size_t numOfFrames = motion->numOfFrames;
+    const size_t sourceFirstFrame = motion->sourceFirstFrame;
+    const size_t sourceFrameStep = motion->sourceFrameStep;
+    const size_t numOfSourceFramesToScan =
+        numOfFrames > 0
+            ? sourceFirstFrame + (numOfFrames - 1) * sourceFrameStep + 1
+            : 0;
+    numOfFramesPerChunk = std::max<size_t>(numOfFramesPerChunk, 1);
+
+    // bytes before the frame lines count as scanned
+    const size_t numOfScannedBytesBefore =
+        config.progress ? config.progress->numOfTotalBytes - remaining.size()
+                        : 0;
+
+    std::vector<BVHMotionChunk> chunks;
+    for (size_t sourceFrame = 0; sourceFrame < numOfSourceFramesToScan;
+         sourceFrame++) {
+        if (sourceFrame % NUM_OF_FRAMES_PER_PROGRESS_REPORT == 0 &&
+            config.progress) {
+            throwIfCancelled();
+            config.progress->numOfScannedBytes =
+                numOfScannedBytesBefore + (p - remaining.data());
+        }
+
+        if (p >= end) {
             std::string msg;
             msg += "The number of frames is smaller than the Hierarchy section "
                    "specification (";
-            msg += motion->numOfFrames;
+            msg += std::to_string(motion->numOfSourceFrames);
             msg += ").";
-            throw parse_failed_error(msg, inputStream);
+            throw parse_failed_error(
+                msg, firstLineNum + static_cast<uint32_t>(sourceFrame), 1, {});
         }
 
-        strStream << input;
+        const bool isFrameToLoad =
+            sourceFrame >= sourceFirstFrame &&
+            (sourceFrame - sourceFirstFrame) % sourceFrameStep == 0;
+        if (isFrameToLoad && checkNumOfValues) {
+            const char *cursor = p;
+            checkNumOfFrameLineValues(
+                readFrameLine(cursor, end),
+                firstLineNum + static_cast<uint32_t>(sourceFrame),
+                channelWritePlan.size());
+        }
 
-        // allocate JointState for current frame
-        for (size_t jointIdx = 0; jointIdx < skelton.size(); jointIdx++) {
-            motion->jointMotions[jointIdx]->jointStates.push_back(
-                std::make_shared<JointState>());
+        if (isFrameToLoad && (sourceFrame - sourceFirstFrame) %
+                                     (sourceFrameStep * numOfFramesPerChunk) ==
+                                 0) {
+            const size_t frame =
+                (sourceFrame - sourceFirstFrame) / sourceFrameStep;
+
+            BVHMotionChunk chunk{};
+            chunk.begin = p;
+            chunk.firstFrame = static_cast<uint32_t>(frame);
+            chunk.numOfFrames = static_cast<uint32_t>(
+                std::min(numOfFramesPerChunk, numOfFrames - frame));
+            chunk.firstLineNum =
+                firstLineNum + static_cast<uint32_t>(sourceFrame);
+            chunk.lineStep = static_cast<uint32_t>(sourceFrameStep);
+            chunks.push_back(chunk);
         }
 
-        for (uint32_t i = 0; i < numOfChannels; i++) {
-            strStream >> value;
-            if (i < numOfChannels - 1 && strStream.eof()) {
-                std::string msg;
-                msg += "The number of channel values is smaller than the "
-                       "Hierarchy section specification (";
-                msg += numOfChannels;
-                msg += ").";
-                throw parse_failed_error(msg, inputStream);
-            }
+        auto lineBreak =
+            static_cast<const char *>(std::memchr(p, '\n', end - p));
+        p = lineBreak ? lineBreak + 1 : end;
+    }
 
-            auto id = motion->channelDescriptionOrder[i].joindId;
-            auto channel = motion->channelDescriptionOrder[i].channel;
-            switch (channel) {
-            case ChannelEnum::Xposition:
-                motion->jointMotions[id]->jointStates[frame]->pos.x = value;
-                break;
-            case ChannelEnum::Yposition:
-                motion->jointMotions[id]->jointStates[frame]->pos.y = value;
-                break;
-            case ChannelEnum::Zposition:
-                motion->jointMotions[id]->jointStates[frame]->pos.z = value;
-                break;
-
-            case ChannelEnum::Xrotation:
-                motion->jointMotions[id]->jointStates[frame]->rot.x = value;
-                break;
-            case ChannelEnum::Yrotation:
-                motion->jointMotions[id]->jointStates[frame]->rot.y = value;
-                break;
-            case ChannelEnum::Zrotation:
-                motion->jointMotions[id]->jointStates[frame]->rot.z = value;
-                break;
-            }
+    if (chunks.empty()) {
+        chunks.push_back(BVHMotionChunk{p, 0, 0, firstLineNum, 1});
+    }
+    if (config.progress) {
+        config.progress->numOfScannedBytes =
+            config.progress->numOfTotalBytes.load();
+    }
 
-            motion->jointMotions[id]->ownedChannels.insert(channel);
+    return chunks;
+}
+
+/**
+ * @brief Decode all frame lines in `chunk`.
+ *
+ * Chunks do not share any frame, so they can be decoded concurrently.
+ */
+void BVHParser::decodeMotionChunk(const BVHMotionChunk &chunk) {
+    const auto remaining = tokenizer->getRemaining();
+    const char *const end = remaining.data() + remaining.size();
+    const char *p = chunk.begin;
+
+    for (uint32_t i = 0; i < chunk.numOfFrames; i++) {
+        if (i > 0) {
+            skipFrameLines(p, end, chunk.lineStep - 1);
+        }
+        decodeFrameLine(readFrameLine(p, end),
+                        chunk.firstLineNum + i * chunk.lineStep,
+                        channelWritePlan,
+                        motion->getFrameValues(chunk.firstFrame + i));
+
+        if ((i + 1) % NUM_OF_FRAMES_PER_PROGRESS_REPORT == 0 &&
+            config.progress) {
+            config.progress->numOfDecodedFrames +=
+                NUM_OF_FRAMES_PER_PROGRESS_REPORT;
+            throwIfCancelled();
         }
     }
+
+    if (config.progress) {
+        config.progress->numOfDecodedFrames +=
+            chunk.numOfFrames % NUM_OF_FRAMES_PER_PROGRESS_REPORT;
+    }
+}
+
+void BVHParser::throwIfCancelled() const {
+    if (config.progress && config.progress->isCancelRequested()) {
+        throw parse_cancelled_error();
+    }
 }
 
 void BVHParser::parseBVH() {
     motion = std::make_shared<Motion>();
     ClosestChildMap closestChildMap;
 
-    try {
-        // Hierarchy section definition
-        std::string input;
-        *inputStream >> input;
-        if (input != TOKEN_TOP) {
-            std::string msg;
-            msg += "Top of .bvh file should be '";
-            msg += TOKEN_TOP;
-            msg += "'.";
-            throw parse_failed_error(msg, inputStream);
-        }
-        parseJoints(false, closestChildMap);
+    // Hierarchy section definition
+    std::string_view input = tokenizer->next();
+    if (input != TOKEN_TOP) {
+        std::string msg;
+        msg += "Top of .bvh file should be '";
+        msg += TOKEN_TOP;
+        msg += "'.";
+        throw parse_failed_error(msg, *tokenizer);
+    }
+    parseJoints(false, closestChildMap);
+
+    // sort by ID
+    std::sort(skelton.begin(), skelton.end(),
+              [](const std::shared_ptr<Animator::Joint> &a,
+                 const std::shared_ptr<Animator::Joint> &b) {
+                  return a->getID() < b->getID();
+              });
+
+    // register closest child id
+    for (auto &joint : skelton) {
+        joint->setClosestChildIDs(closestChildMap[joint->getID()]);
+    }
 
-        // sort by ID
-        std::sort(skelton.begin(), skelton.end(),
-                  [](const std::shared_ptr<Animator::Joint> &a,
-                     const std::shared_ptr<Animator::Joint> &b) {
-                      return a->getID() < b->getID();
-                  });
+    // Motion section definition
+    input = tokenizer->next();
+    if (input != TOKEN_MOTION) {
+        std::string msg;
+        msg += "Start of motion section should be '";
+        msg += TOKEN_MOTION;
+        msg += "'.";
+        throw parse_failed_error(msg, *tokenizer);
+    }
+    parseMotion();
+}
 
-        // register closest child id
-        for (auto &joint : skelton) {
-            joint->setClosestChildIDs(closestChildMap[joint->getID()]);
-        }
+BVHParser::BVHParser(std::string filePath, BVHParserConfig config) {
+    this->filePath = filePath;
+    this->config = config;
+    tokenizer = std::make_shared<BVHTokenizer>(filePath);
 
-        // Motion section definition
-        *inputStream >> input;
-        if (input != TOKEN_MOTION) {
-            std::string msg;
-            msg += "Start of motion section should be '";
-            msg += TOKEN_MOTION;
-            msg += "'.";
-            throw parse_failed_error(msg, inputStream);
-        }
-        parseMotion();
-    } catch (parse_failed_error e) {
-        std::cerr << e.what() << std::endl;
-        std::cerr << e.where() << std::endl;
-        exit(1);
+    if (this->config.progress) {
+        this->config.progress->numOfTotalBytes =
+            tokenizer->getRemaining().size();
     }
 }
 
-BVHParser::BVHParser(std::string filePath) {
-    this->filePath = filePath;
-    inputStream = std::make_unique<std::ifstream>(filePath);
+// ----------------------------------------
+// BVHFrameDecoder
+// ----------------------------------------
+
+BVHFrameDecoder::BVHFrameDecoder(std::shared_ptr<BVHTokenizer> tokenizer,
+                                 std::vector<BVHMotionChunk> chunks,
+                                 std::vector<uint32_t> channelWritePlan,
+                                 size_t numOfJoints)
+    : tokenizer(tokenizer), chunks(chunks), channelWritePlan(channelWritePlan),
+      frameStride(numOfJoints * NUM_OF_JOINT_STATE_VALUES) {
+    const auto remaining = tokenizer->getRemaining();
+    end = remaining.data() + remaining.size();
+    numOfFramesPerChunk = std::max(this->chunks.front().numOfFrames, 1U);
+}
 
-    if (!inputStream->is_open()) {
-        std::string msg;
-        msg += "failed to open .bvh file '";
-        msg += filePath;
-        msg += "'.";
-        throw std::runtime_error(msg);
+size_t BVHFrameDecoder::getNumOfFramesPerChunk() const {
+    return numOfFramesPerChunk;
+}
+
+void BVHFrameDecoder::decodeChunk(size_t chunkIndex, float *values) const {
+    const BVHMotionChunk &chunk = chunks.at(chunkIndex);
+    const char *p = chunk.begin;
+
+    for (uint32_t i = 0; i < chunk.numOfFrames; i++) {
+        if (i > 0) {
+            skipFrameLines(p, end, chunk.lineStep - 1);
+        }
+        decodeFrameLine(readFrameLine(p, end),
+                        chunk.firstLineNum + i * chunk.lineStep,
+                        channelWritePlan, values + i * frameStride);
     }
 }
 
-bool isValidChannel(std::string str) {
+// ----------------------------------------
+// Helper functions
+// ----------------------------------------
+
+bool isValidChannel(std::string_view str) {
     return (str == "Xposition" || str == "Yposition" || str == "Zposition" ||
             str == "Xrotation" || str == "Yrotation" || str == "Zrotation");
 }
+
+bool convertTokenToFloat(std::string_view token, float &value) {
+    const char *tokenEnd = token.data() + token.size();
+    return !token.empty() &&
+           parseFloat(token.data(), tokenEnd, value) == tokenEnd;
+}
+
+bool convertTokenToSize(std::string_view token, size_t &value) {
+    const char *tokenEnd = token.data() + token.size();
+    return !token.empty() &&
+           parseSize(token.data(), tokenEnd, value) == tokenEnd;
+}
+
+/// Return the line from `cursor` without the line break and move `cursor` to
+/// the beginning of the next line.
+std::string_view readFrameLine(const char *&cursor, const char *end) {
+    auto lineBreak = static_cast<const char *>(
+        cursor < end ? std::memchr(cursor, '\n', end - cursor) : nullptr);
+    const char *lineEnd = lineBreak ? lineBreak : end;
+    const char *lineBegin = cursor;
+    cursor = lineBreak ? lineBreak + 1 : end;
+
+    if (lineEnd > lineBegin && *(lineEnd - 1) == '\r') {
+        lineEnd--;
+    }
+    return std::string_view(lineBegin, lineEnd - lineBegin);
+}
+
+/// Move `cursor` to the beginning of the `numOfLines`-th next line by
+/// scanning line breaks only.
+void skipFrameLines(const char *&cursor, const char *end,
+                    uint32_t numOfLines) {
+    for (uint32_t i = 0; i < numOfLines && cursor < end; i++) {
+        auto lineBreak = static_cast<const char *>(
+            std::memchr(cursor, '\n', end - cursor));
+        cursor = lineBreak ? lineBreak + 1 : end;
+    }
+}
+
+std::string createTooFewValuesMessage(size_t numOfChannels) {
+    std::string msg;
+    msg += "The number of channel values is smaller than the "
+           "Hierarchy section specification (";
+    msg += std::to_string(numOfChannels);
+    msg += ").";
+    return msg;
+}
+
+std::string createTooManyValuesMessage(size_t numOfChannels) {
+    std::string msg;
+    msg += "The number of channel values is larger than the "
+           "Hierarchy section specification (";
+    msg += std::to_string(numOfChannels);
+    msg += ").";
+    return msg;
+}
+
+/**
+ * @brief Decode channel values of a frame line in place.
+ *
+ * Values are parsed directly from `line` without copying, and the number of
+ * values must match the Hierarchy section specification.
+ *
+ * @param line frame line without the line break
+ * @param lineNum line number of `line` for error reporting
+ * @param channelWritePlan destination of each value in `frameValues`
+ * @param frameValues values of the frame to write to
+ */
+void decodeFrameLine(std::string_view line, uint32_t lineNum,
+                     const std::vector<uint32_t> &channelWritePlan,
+                     float *frameValues) {
+    const size_t numOfChannels = channelWritePlan.size();
+    const uint32_t *const writePlan = channelWritePlan.data();
+    const char *const lineBegin = line.data();
+    const char *const lineEnd = lineBegin + line.size();
+    const char *p = lineBegin;
+
+    const auto throwFrameLineError = [&](const std::string &msg) {
+        throw parse_failed_error(
+            msg, lineNum, static_cast<uint32_t>(p - lineBegin) + 1, line);
+    };
+    const auto skipSpaces = [&]() {
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+    };
+
+    float value;
+    for (size_t i = 0; i < numOfChannels; i++) {
+        skipSpaces();
+        if (p == lineEnd) {
+            throwFrameLineError(createTooFewValuesMessage(numOfChannels));
+        }
+
+        const char *valueEnd = parseFloat(p, lineEnd, value);
+        if (valueEnd == nullptr ||
+            (valueEnd < lineEnd && *valueEnd != ' ' && *valueEnd != '\t')) {
+            throwFrameLineError("Invalid channel value (float value).");
+        }
+        p = valueEnd;
+
+        frameValues[writePlan[i]] = value;
+    }
+
+    skipSpaces();
+    if (p != lineEnd) {
+        throwFrameLineError(createTooManyValuesMessage(numOfChannels));
+    }
+}
+
+/**
+ * @brief Check the number of values of a frame line without decoding them.
+ *
+ * Throws parse_failed_error at the same position as decodeFrameLine() if
+ * the number of values does not match `numOfChannels`.
+ */
+void checkNumOfFrameLineValues(std::string_view line, uint32_t lineNum,
+                               size_t numOfChannels) {
+    const char *const lineBegin = line.data();
+    const char *const lineEnd = lineBegin + line.size();
+    const char *p = lineBegin;
+
+    const auto isSpace = [](char c) { return c == ' ' || c == '\t'; };
+
+    size_t numOfValues = 0;
+    while (true) {
+        while (p < lineEnd && isSpace(*p)) {
+            p++;
+        }
+        if (p == lineEnd) {
+            break;
+        }
+        if (numOfValues == numOfChannels) {
+            throw parse_failed_error(createTooManyValuesMessage(numOfChannels),
+                                     lineNum,
+                                     static_cast<uint32_t>(p - lineBegin) + 1,
+                                     line);
+        }
+        numOfValues++;
+        while (p < lineEnd && !isSpace(*p)) {
+            p++;
+        }
+    }
+
+    if (numOfValues < numOfChannels) {
+        throw parse_failed_error(createTooFewValuesMessage(numOfChannels),
+                                 lineNum,
+                                 static_cast<uint32_t>(p - lineBegin) + 1,
+                                 line);
+    }
+}
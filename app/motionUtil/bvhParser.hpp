@@ -1,11 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <ikura/ikura.hpp>
 
 #include "./animator.hpp"
+#include "./bvhParserConfig.hpp"
+#include "./bvhTokenizer.hpp"
 #include "./common.hpp"
 
 #define TOKEN_TOP "HIERARCHY"
@@ -24,67 +29,155 @@
 #define TOKEN_BEGGIN_BRACKET "{"
 #define TOKEN_END_BRACKET "}"
 
+// Max number of characters shown on each side of the error column
+#define PARSE_ERROR_SNIPPET_RADIUS 40
+
+/**
+ * @brief Thrown when a .bvh file does not follow the format.
+ *
+ * The position is given by the parser, which tracks it while reading, so
+ * the file is never read again to locate an error.
+ */
 class parse_failed_error : public std::runtime_error {
-    std::string errorLine;
+    // part of the error line around the error column
+    std::string errorSnippet;
+    // 0-based position of the error column in `errorSnippet`
+    size_t errorSnippetColumn = 0;
     uint32_t errorLineNum;
+    uint32_t errorColumnNum;
 
   public:
-    parse_failed_error(std::string msg,
-                       const std::unique_ptr<std::ifstream> &ist)
+    parse_failed_error(std::string msg, uint32_t lineNum, uint32_t columnNum,
+                       std::string_view line)
         : std::runtime_error("parse failed: " + msg) {
 
-        errorLineNum = 0;
-        errorLine = {};
-
-        uint32_t pos = ist->tellg();
-        ist->seekg(0);
+        errorLineNum = lineNum;
+        errorColumnNum = columnNum;
 
-        std::string line;
-        while (std::getline(*ist, line)) {
-            if (pos < ist->tellg()) {
-                errorLine = line;
-                break;
-            }
-            errorLineNum++;
+        if (line.empty()) {
+            errorSnippet = "<unknown>";
+            return;
         }
-        errorLineNum++;
 
-        if (errorLine.empty()) {
-            errorLine = "<unknown>";
+        // clip long lines around the error column
+        const size_t column =
+            std::min<size_t>(columnNum > 0 ? columnNum - 1 : 0, line.size());
+        const size_t snippetBegin =
+            column > PARSE_ERROR_SNIPPET_RADIUS
+                ? column - PARSE_ERROR_SNIPPET_RADIUS
+                : 0;
+        const size_t snippetEnd =
+            std::min(column + PARSE_ERROR_SNIPPET_RADIUS, line.size());
+
+        if (snippetBegin > 0) {
+            errorSnippet += "...";
         }
+        errorSnippetColumn = errorSnippet.size() + column - snippetBegin;
+        errorSnippet += line.substr(snippetBegin, snippetEnd - snippetBegin);
+        if (snippetEnd < line.size()) {
+            errorSnippet += "...";
+        }
+
+        // keep the caret aligned
+        std::replace(errorSnippet.begin(), errorSnippet.end(), '\t', ' ');
     }
 
-    std::string where() {
+    parse_failed_error(std::string msg, const BVHTokenizer &tokenizer)
+        : parse_failed_error(msg, tokenizer.getLineNum(),
+                             tokenizer.getColumnNum(), tokenizer.getLine()) {}
+
+    uint32_t getLineNum() const { return errorLineNum; }
+    uint32_t getColumnNum() const { return errorColumnNum; }
+
+    /// Position and the error line with a caret under the error column.
+    std::string where() const {
         std::string res;
         res += "line: ";
         res += std::to_string(errorLineNum);
+        res += ", column: ";
+        res += std::to_string(errorColumnNum);
         res += "\n";
-        res += errorLine;
+        res += errorSnippet;
+        res += "\n";
+        res += std::string(errorSnippetColumn, ' ');
+        res += "^";
 
         return res;
     }
 };
 
+/// Thrown when parsing is cancelled through BVHParseProgress.
+class parse_cancelled_error : public std::runtime_error {
+  public:
+    parse_cancelled_error() : std::runtime_error("parse cancelled") {}
+};
+
+/// Frame lines in the MOTION section, every `lineStep` lines from `begin`.
+struct BVHMotionChunk {
+    const char *begin;
+    uint32_t firstFrame;
+    uint32_t numOfFrames;
+    uint32_t firstLineNum;
+    uint32_t lineStep;
+};
+
+/**
+ * @brief Decodes frames of a .bvh file from an index of frame lines.
+ *
+ * Created by BVHParser when BVHParserConfig::lazyMotionDecoding is set.
+ * Holds the tokenizer so the bytes of the file stay available.
+ */
+class BVHFrameDecoder : public FrameDecoder {
+    std::shared_ptr<BVHTokenizer> tokenizer;
+    /// The first line of every `numOfFramesPerChunk` frames.
+    std::vector<BVHMotionChunk> chunks;
+    std::vector<uint32_t> channelWritePlan;
+    size_t frameStride;
+    uint32_t numOfFramesPerChunk;
+    const char *end;
+
+  public:
+    BVHFrameDecoder(std::shared_ptr<BVHTokenizer> tokenizer,
+                    std::vector<BVHMotionChunk> chunks,
+                    std::vector<uint32_t> channelWritePlan,
+                    size_t numOfJoints);
+
+    size_t getNumOfFramesPerChunk() const override;
+    /// Throws parse_failed_error if a frame line is invalid.
+    void decodeChunk(size_t chunkIndex, float *values) const override;
+};
+
 class BVHParser {
     typedef std::map<ikura::GroupID, std::vector<ikura::GroupID>>
         ClosestChildMap;
 
     void parseJoints(bool isJointTokenRead, ClosestChildMap &closestChildMap);
     void parseMotion();
+    void selectFramesToLoad();
+    std::vector<BVHMotionChunk>
+    splitMotionIntoChunks(size_t numOfFramesPerChunk,
+                          bool checkNumOfValues = false);
+    void decodeMotionChunk(const BVHMotionChunk &chunk);
+    void throwIfCancelled() const;
 
     std::vector<std::shared_ptr<Animator::Joint>> skelton;
     std::shared_ptr<Motion> motion;
+    /// Destination of each channel value in a frame line, relative to
+    /// Motion::getFrameValues(). Built from the Hierarchy section.
+    std::vector<uint32_t> channelWritePlan;
 
-    std::unique_ptr<std::ifstream> inputStream;
+    std::shared_ptr<BVHTokenizer> tokenizer;
     bool isRootDefined = false;
     ikura::GroupID currentID = 0;
     std::vector<ikura::GroupID> jointIDStack;
 
     std::string filePath;
+    BVHParserConfig config;
 
   public:
-    BVHParser(std::string filePath);
+    BVHParser(std::string filePath, BVHParserConfig config = {});
 
+    /// Throws parse_failed_error if the file does not follow the format.
     void parseBVH();
     std::vector<std::shared_ptr<Animator::Joint>> getSkentonData() {
         return skelton;
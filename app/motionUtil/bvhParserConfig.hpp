@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+/**
+ * @brief Progress of BVHParser shared with other threads.
+ *
+ * All members can be read and written from any thread while parsing.
+ */
+struct BVHParseProgress {
+    /// Bytes of the file scanned for frame lines / size of the file.
+    std::atomic<size_t> numOfScannedBytes{0};
+    std::atomic<size_t> numOfTotalBytes{0};
+    /// Frames decoded / frames in the file (0 until the MOTION section).
+    std::atomic<size_t> numOfDecodedFrames{0};
+    std::atomic<size_t> numOfTotalFrames{0};
+    /// Set true to make the parser throw parse_cancelled_error.
+    std::atomic<bool> cancelRequested{false};
+
+    bool isCancelRequested() const { return cancelRequested.load(); }
+};
+
+struct BVHParserConfig {
+    /// Load only frames [firstFrame, lastFrame] (0-based, inclusive) of the
+    /// file, every `frameStep` frames. lastFrame is clamped to the last frame.
+    size_t firstFrame = 0;
+    size_t lastFrame = std::numeric_limits<size_t>::max();
+    size_t frameStep = 1;
+
+    /// Decode MOTION frame lines on worker threads.
+    bool parallelMotionParsing = true;
+    /// Number of worker threads. 0 means the number of hardware threads.
+    uint32_t numOfWorkerThreads = 0;
+    /// Only index frame lines of the MOTION section and decode frames when
+    /// they are accessed. Memory scales with the decoded chunk cache instead
+    /// of the number of frames.
+    bool lazyMotionDecoding = false;
+    /// With lazyMotionDecoding, frames between indexed frame lines. Frames
+    /// are decoded in chunks of this size.
+    uint32_t numOfFramesPerFrameIndex = 256;
+    /// With lazyMotionDecoding, max number of decoded chunks kept in memory.
+    size_t maxNumOfDecodedChunks = 64;
+    /// Progress reported while parsing. Can be nullptr.
+    std::shared_ptr<BVHParseProgress> progress;
+};
@@ -0,0 +1,118 @@
+#include "./bvhTokenizer.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' ||
+           c == '\f';
+}
+
+/// Find the line break from `p`. Returns `end` if there is no more line break.
+const char *findLineBreak(const char *p, const char *end) {
+    if (p >= end) {
+        return end;
+    }
+    auto found = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    return found ? found : end;
+}
+
+std::string_view trimCarriageReturn(const char *lineBegin,
+                                    const char *lineEnd) {
+    if (lineEnd > lineBegin && *(lineEnd - 1) == '\r') {
+        lineEnd--;
+    }
+    return std::string_view(lineBegin, lineEnd - lineBegin);
+}
+} // namespace
+
+BVHTokenizer::BVHTokenizer(const std::string &filePath) {
+    if (MappedFile::isMappable(filePath)) {
+        mappedFile = std::make_unique<MappedFile>(filePath);
+        begin = mappedFile->getData();
+        end = begin + mappedFile->getSize();
+    } else {
+        std::ifstream inputStream(filePath, std::ios::binary);
+        if (!inputStream.is_open()) {
+            std::string msg;
+            msg += "failed to open .bvh file '";
+            msg += filePath;
+            msg += "'.";
+            throw std::runtime_error(msg);
+        }
+        bufferedFile.assign(std::istreambuf_iterator<char>(inputStream),
+                            std::istreambuf_iterator<char>());
+        begin = bufferedFile.data();
+        end = begin + bufferedFile.size();
+    }
+
+    cursor = begin;
+    currentLineBegin = begin;
+    tokenLineBegin = begin;
+    tokenBegin = begin;
+}
+
+void BVHTokenizer::skipWhitespaces() {
+    while (cursor < end && isWhitespace(*cursor)) {
+        if (*cursor == '\n') {
+            currentLineNum++;
+            currentLineBegin = cursor + 1;
+        }
+        cursor++;
+    }
+}
+
+std::string_view BVHTokenizer::next() {
+    skipWhitespaces();
+
+    tokenLineNum = currentLineNum;
+    tokenLineBegin = currentLineBegin;
+    tokenBegin = cursor;
+
+    while (cursor < end && !isWhitespace(*cursor)) {
+        cursor++;
+    }
+
+    return std::string_view(tokenBegin, cursor - tokenBegin);
+}
+
+std::string_view BVHTokenizer::nextLine() {
+    tokenLineNum = currentLineNum;
+    tokenLineBegin = currentLineBegin;
+    tokenBegin = cursor;
+
+    const char *lineEnd = findLineBreak(cursor, end);
+    auto line = trimCarriageReturn(cursor, lineEnd);
+
+    if (lineEnd < end) {
+        cursor = lineEnd + 1;
+        currentLineNum++;
+        currentLineBegin = cursor;
+    } else {
+        cursor = end;
+    }
+
+    return line;
+}
+
+bool BVHTokenizer::isEOF() const { return cursor >= end; }
+
+std::string_view BVHTokenizer::getRemaining() const {
+    return std::string_view(cursor, end - cursor);
+}
+
+uint32_t BVHTokenizer::getCurrentLineNum() const { return currentLineNum; }
+
+uint32_t BVHTokenizer::getLineNum() const { return tokenLineNum; }
+
+uint32_t BVHTokenizer::getColumnNum() const {
+    return static_cast<uint32_t>(tokenBegin - tokenLineBegin) + 1;
+}
+
+std::string_view BVHTokenizer::getLine() const {
+    return trimCarriageReturn(tokenLineBegin,
+                              findLineBreak(tokenLineBegin, end));
+}
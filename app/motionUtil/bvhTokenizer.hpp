@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "../util/mappedFile.hpp"
+
+/**
+ * @brief Whitespace separated tokenizer over the bytes of a .bvh file.
+ *
+ * Regular files are memory-mapped and tokens are handed out as
+ * std::string_view into the mapped bytes, so no token is copied.
+ * Other files (pipes etc.) are read into memory with std::ifstream once.
+ *
+ * Line and column of the last returned token are tracked while reading,
+ * so parse errors can be located without reading the file again.
+ */
+class BVHTokenizer {
+    std::unique_ptr<MappedFile> mappedFile;
+    // holds the file contents when it cannot be mapped
+    std::string bufferedFile;
+
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    const char *cursor = nullptr;
+
+    // position of `cursor`
+    uint32_t currentLineNum = 1;
+    const char *currentLineBegin = nullptr;
+
+    // position of the last token returned from next() / nextLine()
+    uint32_t tokenLineNum = 1;
+    const char *tokenLineBegin = nullptr;
+    const char *tokenBegin = nullptr;
+
+    void skipWhitespaces();
+
+  public:
+    BVHTokenizer(const std::string &filePath);
+
+    /// Return next whitespace separated token.
+    /// Returns an empty string_view at the end of file.
+    std::string_view next();
+    /// Return the rest of the current line without the line break and move to
+    /// the beginning of the next line.
+    std::string_view nextLine();
+
+    bool isEOF() const;
+    /// Unread bytes from the current position.
+    std::string_view getRemaining() const;
+    /// 1-based line number of the current position.
+    uint32_t getCurrentLineNum() const;
+
+    /// 1-based line number of the last token.
+    uint32_t getLineNum() const;
+    /// 1-based column of the last token.
+    uint32_t getColumnNum() const;
+    /// The whole line containing the last token (without the line break).
+    std::string_view getLine() const;
+};
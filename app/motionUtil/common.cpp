@@ -1,5 +1,136 @@
 #include "./common.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
+// ----------------------------------------
+// Motion
+// ----------------------------------------
+
+void Motion::allocateFrames(size_t numOfJoints, size_t numOfFrames) {
+    this->numOfJoints = numOfJoints;
+    this->numOfFrames = numOfFrames;
+
+    externalFrameValues = nullptr;
+    externalFrameValuesOwner.reset();
+
+    frameValues.clear();
+    frameValues.resize(numOfFrames * getFrameStride(), 0.0f);
+}
+
+void Motion::attachExternalFrames(std::shared_ptr<const void> owner,
+                                  const float *values, size_t numOfJoints,
+                                  size_t numOfFrames) {
+    this->numOfJoints = numOfJoints;
+    this->numOfFrames = numOfFrames;
+
+    frameValues.clear();
+    frameValues.shrink_to_fit();
+    externalFrameValues = values;
+    externalFrameValuesOwner = owner;
+}
+
+void Motion::attachFrameDecoder(std::shared_ptr<FrameDecoder> decoder,
+                                size_t numOfJoints, size_t numOfFrames,
+                                size_t maxNumOfDecodedChunks) {
+    this->numOfJoints = numOfJoints;
+    this->numOfFrames = numOfFrames;
+
+    frameValues.clear();
+    frameValues.shrink_to_fit();
+    frameDecoder = decoder;
+    this->maxNumOfDecodedChunks = std::max<size_t>(maxNumOfDecodedChunks, 1);
+    decodedChunks.clear();
+}
+
+bool Motion::hasAllFrameValues() const { return frameDecoder == nullptr; }
+
+size_t Motion::getFrameStride() const {
+    return numOfJoints * NUM_OF_JOINT_STATE_VALUES;
+}
+
+size_t Motion::getJointOffset(ikura::GroupID jointID) {
+    return jointID * NUM_OF_JOINT_STATE_VALUES;
+}
+
+float *Motion::getFrameValues(size_t frame) {
+    assert(externalFrameValues == nullptr);
+    return frameValues.data() + frame * getFrameStride();
+}
+
+const float *Motion::getFrameValues(size_t frame) const {
+    if (frameDecoder) {
+        return getDecodedFrameValues(frame);
+    }
+
+    const float *values =
+        externalFrameValues ? externalFrameValues : frameValues.data();
+    return values + frame * getFrameStride();
+}
+
+const float *Motion::getDecodedFrameValues(size_t frame) const {
+    const size_t numOfFramesPerChunk = frameDecoder->getNumOfFramesPerChunk();
+    const size_t chunkIndex = frame / numOfFramesPerChunk;
+    const size_t frameInChunk = frame % numOfFramesPerChunk;
+
+    auto found = std::find_if(decodedChunks.begin(), decodedChunks.end(),
+                              [&](const DecodedChunk &chunk) {
+                                  return chunk.chunkIndex == chunkIndex;
+                              });
+    if (found != decodedChunks.end()) {
+        // mark as most recently used
+        decodedChunks.splice(decodedChunks.begin(), decodedChunks, found);
+    } else {
+        // reuse the buffer of the least recently used chunk
+        if (decodedChunks.size() >= maxNumOfDecodedChunks) {
+            decodedChunks.splice(decodedChunks.begin(), decodedChunks,
+                                 std::prev(decodedChunks.end()));
+        } else {
+            decodedChunks.emplace_front();
+        }
+
+        DecodedChunk &chunk = decodedChunks.front();
+        chunk.chunkIndex = chunkIndex;
+        chunk.values.assign(numOfFramesPerChunk * getFrameStride(), 0.0f);
+        try {
+            frameDecoder->decodeChunk(chunkIndex, chunk.values.data());
+        } catch (...) {
+            decodedChunks.pop_front();
+            throw;
+        }
+    }
+
+    return decodedChunks.front().values.data() +
+           frameInChunk * getFrameStride();
+}
+
+float Motion::getChannelValue(size_t frame, ikura::GroupID jointID,
+                              ChannelEnum channel) const {
+    return getFrameValues(frame)[getJointOffset(jointID) + channel];
+}
+
+JointState Motion::getJointState(size_t frame, ikura::GroupID jointID) const {
+    const float *values = getFrameValues(frame) + getJointOffset(jointID);
+
+    JointState js{};
+    js.pos = glm::vec3(values[ChannelEnum::Xposition],
+                       values[ChannelEnum::Yposition],
+                       values[ChannelEnum::Zposition]);
+    js.rot = glm::vec3(values[ChannelEnum::Xrotation],
+                       values[ChannelEnum::Yrotation],
+                       values[ChannelEnum::Zrotation]);
+    return js;
+}
+
+size_t Motion::getSourceFrameIndex(size_t frame) const {
+    return sourceFirstFrame + frame * sourceFrameStep;
+}
+
+// ----------------------------------------
+// Conversion functions
+// ----------------------------------------
+
 ChannelEnum convertStrToChannelEnum(std::string str) {
     if (str == "Xposition")
         return Xposition;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <list>
 #include <memory>
 #include <set>
 #include <stdexcept>
@@ -11,6 +12,7 @@
 
 #include <ikura/ikura.hpp>
 
+/// The order is also the order of values of a joint in Motion::frameValues.
 enum ChannelEnum {
     Xposition,
     Yposition,
@@ -22,27 +24,110 @@ enum ChannelEnum {
 
 enum RotationAxisEnum { X, Y, Z };
 
+/// Number of values stored for each joint in a frame (one per ChannelEnum).
+const size_t NUM_OF_JOINT_STATE_VALUES = 6;
+
 struct JointState {
     glm::vec3 pos = {};
     glm::vec3 rot = {};
 };
 
-struct JointMotion {
-    std::vector<std::shared_ptr<JointState>> jointStates;
-    std::set<ChannelEnum> ownedChannels;
-};
-
 struct ChannelJointCorrespondance {
     ikura::GroupID joindId;
     ChannelEnum channel;
 };
 
+/**
+ * @brief Decodes frame values of a Motion on demand, a chunk of frames at a
+ * time.
+ *
+ * Chunk `i` holds frames [i * getNumOfFramesPerChunk(), (i + 1) *
+ * getNumOfFramesPerChunk()), the last chunk may be shorter.
+ */
+class FrameDecoder {
+  public:
+    virtual ~FrameDecoder() = default;
+
+    virtual size_t getNumOfFramesPerChunk() const = 0;
+    /// Write values of all frames of chunk `chunkIndex` to `values` in the
+    /// layout of Motion::frameValues. Can be called from any thread.
+    virtual void decodeChunk(size_t chunkIndex, float *values) const = 0;
+};
+
 struct Motion {
-    std::vector<std::shared_ptr<JointMotion>> jointMotions;
+    /// Channel values of all frames in one contiguous frame-major buffer.
+    /// Channels not owned by a joint are 0.
+    /// [frame * getFrameStride() + getJointOffset(jointID) + channel]
+    std::vector<float> frameValues;
+    /// Frame values held outside of `frameValues` (e.g. in a mapped motion
+    /// cache file), laid out the same way. nullptr if `frameValues` is used.
+    const float *externalFrameValues = nullptr;
+    /// Keeps the memory of `externalFrameValues` alive.
+    std::shared_ptr<const void> externalFrameValuesOwner;
+    /// Decodes frame values on demand instead of holding all of them.
+    /// nullptr if all frame values are held.
+    std::shared_ptr<FrameDecoder> frameDecoder;
+    /// Channels owned by each joint. [jointID]
+    std::vector<std::set<ChannelEnum>> ownedChannels;
     std::array<RotationAxisEnum, 3> rotationOrder;
     std::vector<ChannelJointCorrespondance> channelDescriptionOrder;
+    size_t numOfJoints;
     size_t numOfFrames;
+    /// Time between loaded frames.
     float frameRate;
+
+    /// Loaded frame `i` is frame `sourceFirstFrame + i * sourceFrameStep`
+    /// (0-based) of the source file, which has `numOfSourceFrames` frames.
+    size_t sourceFirstFrame = 0;
+    size_t sourceFrameStep = 1;
+    size_t numOfSourceFrames = 0;
+
+    /// Allocate zero-filled values for `numOfFrames` frames.
+    void allocateFrames(size_t numOfJoints, size_t numOfFrames);
+    /// Use `values` owned by `owner` as the values of all frames instead of
+    /// allocating them. The values are read-only.
+    void attachExternalFrames(std::shared_ptr<const void> owner,
+                              const float *values, size_t numOfJoints,
+                              size_t numOfFrames);
+
+    /// Decode frame values with `decoder` when they are accessed, keeping at
+    /// most `maxNumOfDecodedChunks` chunks of decoded frames.
+    /// Frame values of such a Motion must be read from one thread at a time,
+    /// as reading them replaces decoded chunks.
+    void attachFrameDecoder(std::shared_ptr<FrameDecoder> decoder,
+                            size_t numOfJoints, size_t numOfFrames,
+                            size_t maxNumOfDecodedChunks);
+    /// Return true if all frame values are held in memory.
+    bool hasAllFrameValues() const;
+
+    /// Number of values in a frame.
+    size_t getFrameStride() const;
+    /// Offset of the first value of `jointID` in a frame.
+    static size_t getJointOffset(ikura::GroupID jointID);
+
+    /// Writable values of `frame`. Not available for external frames.
+    float *getFrameValues(size_t frame);
+    /// With a frame decoder, the returned pointer is valid until the next
+    /// access to frame values of this Motion, and the Motion must not be
+    /// read from other threads (see attachFrameDecoder()).
+    /// Throws the error of FrameDecoder::decodeChunk() if decoding fails.
+    const float *getFrameValues(size_t frame) const;
+    float getChannelValue(size_t frame, ikura::GroupID jointID,
+                          ChannelEnum channel) const;
+    JointState getJointState(size_t frame, ikura::GroupID jointID) const;
+    /// 0-based frame index in the source file of loaded frame `frame`.
+    size_t getSourceFrameIndex(size_t frame) const;
+
+  private:
+    struct DecodedChunk {
+        size_t chunkIndex;
+        std::vector<float> values;
+    };
+    size_t maxNumOfDecodedChunks = 0;
+    /// Most recently used first.
+    mutable std::list<DecodedChunk> decodedChunks;
+
+    const float *getDecodedFrameValues(size_t frame) const;
 };
 
 ChannelEnum convertStrToChannelEnum(std::string str);
@@ -0,0 +1,327 @@
+#include "./eulerRotation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+// EULER_ROTATION_FORCE_SCALAR selects the scalar kernels on any target,
+// so that tests can compare them with the SIMD ones.
+#if defined(EULER_ROTATION_FORCE_SCALAR)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define EULER_ROTATION_USE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) ||                                 \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EULER_ROTATION_USE_SSE2
+#endif
+
+// sin / cos of angles in degrees are calculated as below:
+//   1. q = round(deg / 90), r = deg - q * 90 (|r| <= 45)
+//   2. sin(r) and cos(r) by polynomials of r in radians (Cephes sinf / cosf)
+//   3. swap and negate them by the quadrant q
+// Reducing in degrees keeps the error small for large angles.
+
+#define SIN_COEF_0 -1.9515295891e-4f
+#define SIN_COEF_1 8.3321608736e-3f
+#define SIN_COEF_2 -1.6666654611e-1f
+#define COS_COEF_0 2.443315711809948e-5f
+#define COS_COEF_1 -1.388731625493765e-3f
+#define COS_COEF_2 4.166664568298827e-2f
+#define DEGREES_TO_RADIANS 0.01745329251994329577f
+
+namespace {
+
+// ----------------------------------------
+// FloatBatch: the same operation on several joints at a time
+// ----------------------------------------
+
+#if defined(EULER_ROTATION_USE_AVX2)
+
+struct FloatBatch {
+    static constexpr size_t size = 8;
+    __m256 v;
+
+    static FloatBatch broadcast(float f) { return {_mm256_set1_ps(f)}; }
+    static FloatBatch load(const float *p) { return {_mm256_load_ps(p)}; }
+    void store(float *p) const { _mm256_store_ps(p, v); }
+};
+
+inline FloatBatch operator+(FloatBatch a, FloatBatch b) {
+    return {_mm256_add_ps(a.v, b.v)};
+}
+inline FloatBatch operator-(FloatBatch a, FloatBatch b) {
+    return {_mm256_sub_ps(a.v, b.v)};
+}
+inline FloatBatch operator*(FloatBatch a, FloatBatch b) {
+    return {_mm256_mul_ps(a.v, b.v)};
+}
+
+void sinCosDegrees(FloatBatch degrees, FloatBatch &sinValue,
+                   FloatBatch &cosValue) {
+    // rounds to nearest with the default rounding mode
+    const __m256i quadrant = _mm256_cvtps_epi32(
+        _mm256_mul_ps(degrees.v, _mm256_set1_ps(1.0f / 90.0f)));
+    const __m256 x = _mm256_mul_ps(
+        _mm256_sub_ps(degrees.v, _mm256_mul_ps(_mm256_cvtepi32_ps(quadrant),
+                                               _mm256_set1_ps(90.0f))),
+        _mm256_set1_ps(DEGREES_TO_RADIANS));
+    const __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 s = _mm256_set1_ps(SIN_COEF_0);
+    s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(SIN_COEF_1));
+    s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(SIN_COEF_2));
+    s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), x), x);
+
+    __m256 c = _mm256_set1_ps(COS_COEF_0);
+    c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(COS_COEF_1));
+    c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(COS_COEF_2));
+    c = _mm256_add_ps(
+        _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, z), z),
+                      _mm256_mul_ps(z, _mm256_set1_ps(0.5f))),
+        _mm256_set1_ps(1.0f));
+
+    // odd quadrants swap sin and cos
+    const __m256 swapMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(quadrant, _mm256_set1_epi32(1)),
+        _mm256_set1_epi32(1)));
+    // bit 1 of the quadrant moves to the sign bit
+    const __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+    const __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)),
+                         _mm256_set1_epi32(2)),
+        30));
+
+    sinValue.v = _mm256_xor_ps(_mm256_blendv_ps(s, c, swapMask), sinSign);
+    cosValue.v = _mm256_xor_ps(_mm256_blendv_ps(c, s, swapMask), cosSign);
+}
+
+#elif defined(EULER_ROTATION_USE_SSE2)
+
+struct FloatBatch {
+    static constexpr size_t size = 4;
+    __m128 v;
+
+    static FloatBatch broadcast(float f) { return {_mm_set1_ps(f)}; }
+    static FloatBatch load(const float *p) { return {_mm_load_ps(p)}; }
+    void store(float *p) const { _mm_store_ps(p, v); }
+};
+
+inline FloatBatch operator+(FloatBatch a, FloatBatch b) {
+    return {_mm_add_ps(a.v, b.v)};
+}
+inline FloatBatch operator-(FloatBatch a, FloatBatch b) {
+    return {_mm_sub_ps(a.v, b.v)};
+}
+inline FloatBatch operator*(FloatBatch a, FloatBatch b) {
+    return {_mm_mul_ps(a.v, b.v)};
+}
+
+void sinCosDegrees(FloatBatch degrees, FloatBatch &sinValue,
+                   FloatBatch &cosValue) {
+    // rounds to nearest with the default rounding mode
+    const __m128i quadrant =
+        _mm_cvtps_epi32(_mm_mul_ps(degrees.v, _mm_set1_ps(1.0f / 90.0f)));
+    const __m128 x = _mm_mul_ps(
+        _mm_sub_ps(degrees.v,
+                   _mm_mul_ps(_mm_cvtepi32_ps(quadrant), _mm_set1_ps(90.0f))),
+        _mm_set1_ps(DEGREES_TO_RADIANS));
+    const __m128 z = _mm_mul_ps(x, x);
+
+    __m128 s = _mm_set1_ps(SIN_COEF_0);
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_COEF_1));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_COEF_2));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+    __m128 c = _mm_set1_ps(COS_COEF_0);
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_COEF_1));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_COEF_2));
+    c = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z),
+                              _mm_mul_ps(z, _mm_set1_ps(0.5f))),
+                   _mm_set1_ps(1.0f));
+
+    // odd quadrants swap sin and cos
+    const __m128 swapMask = _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    // bit 1 of the quadrant moves to the sign bit
+    const __m128 sinSign = _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+    const __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)),
+                      _mm_set1_epi32(2)),
+        30));
+
+    sinValue.v = _mm_xor_ps(
+        _mm_or_ps(_mm_and_ps(swapMask, c), _mm_andnot_ps(swapMask, s)),
+        sinSign);
+    cosValue.v = _mm_xor_ps(
+        _mm_or_ps(_mm_and_ps(swapMask, s), _mm_andnot_ps(swapMask, c)),
+        cosSign);
+}
+
+#else
+
+struct FloatBatch {
+    static constexpr size_t size = 1;
+    float v;
+
+    static FloatBatch broadcast(float f) { return {f}; }
+    static FloatBatch load(const float *p) { return {*p}; }
+    void store(float *p) const { *p = v; }
+};
+
+inline FloatBatch operator+(FloatBatch a, FloatBatch b) { return {a.v + b.v}; }
+inline FloatBatch operator-(FloatBatch a, FloatBatch b) { return {a.v - b.v}; }
+inline FloatBatch operator*(FloatBatch a, FloatBatch b) { return {a.v * b.v}; }
+
+void sinCosDegrees(FloatBatch degrees, FloatBatch &sinValue,
+                   FloatBatch &cosValue) {
+    const int32_t quadrant =
+        static_cast<int32_t>(std::lrint(degrees.v * (1.0f / 90.0f)));
+    const float x = (degrees.v - static_cast<float>(quadrant) * 90.0f) *
+                    DEGREES_TO_RADIANS;
+    const float z = x * x;
+
+    const float s =
+        ((SIN_COEF_0 * z + SIN_COEF_1) * z + SIN_COEF_2) * z * x + x;
+    const float c = ((COS_COEF_0 * z + COS_COEF_1) * z + COS_COEF_2) * z * z -
+                    z * 0.5f + 1.0f;
+
+    switch (quadrant & 3) {
+    case 0:
+        sinValue.v = s;
+        cosValue.v = c;
+        break;
+    case 1:
+        sinValue.v = c;
+        cosValue.v = -s;
+        break;
+    case 2:
+        sinValue.v = -s;
+        cosValue.v = -c;
+        break;
+    case 3:
+        sinValue.v = -c;
+        cosValue.v = s;
+        break;
+    }
+}
+
+#endif
+
+// ----------------------------------------
+// Rotation matrices of a batch of joints
+// ----------------------------------------
+
+/// 3x3 matrices of a batch of joints, [column * 3 + row]
+typedef std::array<FloatBatch, 9> MatrixBatch;
+
+/// m = m * R(axis), where R(axis) rotates by the angle of `sinValue` /
+/// `cosValue`. Only the 2 columns other than `axis` change.
+template <RotationAxisEnum axis>
+void multiplyAxisRotation(MatrixBatch &m, FloatBatch sinValue,
+                          FloatBatch cosValue) {
+    // (i, j, axis) is a cyclic permutation of (X, Y, Z)
+    constexpr size_t i = (axis + 1) % 3;
+    constexpr size_t j = (axis + 2) % 3;
+
+    for (size_t row = 0; row < 3; row++) {
+        const FloatBatch a = m[i * 3 + row];
+        const FloatBatch b = m[j * 3 + row];
+        m[i * 3 + row] = a * cosValue + b * sinValue;
+        m[j * 3 + row] = b * cosValue - a * sinValue;
+    }
+}
+
+/// m = m * R(axis), where R(axis) rotates by `degrees`.
+template <RotationAxisEnum axis>
+void multiplyAxisRotation(MatrixBatch &m, const float *degrees) {
+    FloatBatch sinValue, cosValue;
+    sinCosDegrees(FloatBatch::load(degrees), sinValue, cosValue);
+    multiplyAxisRotation<axis>(m, sinValue, cosValue);
+}
+
+/// EulerRotationKernel for rotation order (first, second, third).
+template <RotationAxisEnum first, RotationAxisEnum second,
+          RotationAxisEnum third>
+void convertEulerAnglesToRotationMatrices(const float *frameValues,
+                                          size_t numOfJoints,
+                                          glm::mat3 *rotations) {
+
+    constexpr size_t batchSize = FloatBatch::size;
+
+    // rotation channels of the batch, [axis][joint in batch]
+    alignas(32) float angles[3][batchSize];
+    // result of the batch, [column * 3 + row][joint in batch]
+    alignas(32) float elements[9][batchSize];
+
+    for (size_t baseID = 0; baseID < numOfJoints; baseID += batchSize) {
+        const size_t numOfJointsInBatch =
+            std::min(batchSize, numOfJoints - baseID);
+
+        // gather rotation channels, unused lanes are 0
+        for (size_t k = 0; k < batchSize; k++) {
+            if (k >= numOfJointsInBatch) {
+                angles[RotationAxisEnum::X][k] = 0.0f;
+                angles[RotationAxisEnum::Y][k] = 0.0f;
+                angles[RotationAxisEnum::Z][k] = 0.0f;
+                continue;
+            }
+            const float *values =
+                frameValues + Motion::getJointOffset(baseID + k);
+            angles[RotationAxisEnum::X][k] = values[ChannelEnum::Xrotation];
+            angles[RotationAxisEnum::Y][k] = values[ChannelEnum::Yrotation];
+            angles[RotationAxisEnum::Z][k] = values[ChannelEnum::Zrotation];
+        }
+
+        MatrixBatch m;
+        for (size_t e = 0; e < 9; e++) {
+            // identity
+            m[e] = FloatBatch::broadcast(e % 4 == 0 ? 1.0f : 0.0f);
+        }
+        multiplyAxisRotation<first>(m, angles[first]);
+        multiplyAxisRotation<second>(m, angles[second]);
+        multiplyAxisRotation<third>(m, angles[third]);
+
+        // scatter to each joint
+        for (size_t e = 0; e < 9; e++) {
+            m[e].store(elements[e]);
+        }
+        for (size_t k = 0; k < numOfJointsInBatch; k++) {
+            glm::mat3 &rotation = rotations[baseID + k];
+            for (size_t column = 0; column < 3; column++) {
+                for (size_t row = 0; row < 3; row++) {
+                    rotation[column][row] = elements[column * 3 + row][k];
+                }
+            }
+        }
+    }
+}
+
+/// Kernels of all combinations of 3 axes, [first * 9 + second * 3 + third].
+/// Orders repeating an axis are included, a file may declare them.
+template <size_t... indices>
+constexpr std::array<EulerRotationKernel, sizeof...(indices)>
+makeEulerRotationKernelTable(std::index_sequence<indices...>) {
+    return {&convertEulerAnglesToRotationMatrices<
+        static_cast<RotationAxisEnum>(indices / 9),
+        static_cast<RotationAxisEnum>(indices / 3 % 3),
+        static_cast<RotationAxisEnum>(indices % 3)>...};
+}
+
+constexpr std::array<EulerRotationKernel, 27> eulerRotationKernels =
+    makeEulerRotationKernelTable(std::make_index_sequence<27>());
+
+} // namespace
+
+EulerRotationKernel selectEulerRotationKernel(
+    const std::array<RotationAxisEnum, 3> &rotationOrder) {
+    for (RotationAxisEnum axis : rotationOrder) {
+        assert(axis <= RotationAxisEnum::Z);
+    }
+    return eulerRotationKernels[rotationOrder[0] * 9 + rotationOrder[1] * 3 +
+                                rotationOrder[2]];
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "./common.hpp"
+
+/**
+ * @brief Convert rotation channels of all joints in a frame to rotation
+ * matrices in one pass.
+ *
+ * Joints are processed several at a time with SIMD instructions (AVX2 or
+ * SSE2, depending on the build target), or one at a time otherwise.
+ * Each kernel is specialized for one rotation order.
+ *
+ * @param frameValues values of a frame, laid out as Motion::frameValues.
+ * @param numOfJoints number of joints in the frame.
+ * @param rotations receives
+ * R(rotationOrder[0]) * R(rotationOrder[1]) * R(rotationOrder[2])
+ * of each joint, where R(axis) rotates by the channel of `axis` in degrees.
+ */
+typedef void (*EulerRotationKernel)(const float *frameValues,
+                                    size_t numOfJoints, glm::mat3 *rotations);
+
+/// Return the kernel for `rotationOrder`, same as Motion::rotationOrder.
+EulerRotationKernel selectEulerRotationKernel(
+    const std::array<RotationAxisEnum, 3> &rotationOrder);
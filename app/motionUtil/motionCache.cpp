@@ -0,0 +1,475 @@
+#include "./motionCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "../resourceDirectory.hpp"
+#include "../util/mappedFile.hpp"
+
+#define MOTION_CACHE_SIGNATURE "IMVMOTN"
+// increment when the layout of the cache file changes
+#define MOTION_CACHE_VERSION 1
+#define MOTION_CACHE_BYTE_ORDER_MARK 0x01020304U
+// alignment of frame values in the cache file
+#define MOTION_CACHE_FRAMES_ALIGNMENT 64
+
+// size of blocks hashed in createMotionCacheKey()
+#define CONTENT_HASH_EDGE_BLOCK_SIZE (64 * 1024)
+#define CONTENT_HASH_INNER_BLOCK_SIZE (4 * 1024)
+#define CONTENT_HASH_NUM_OF_INNER_BLOCKS 16
+
+namespace {
+/**
+ * @brief Fixed size part at the top of a motion cache file.
+ *
+ * Layout of the file:
+ *   MotionCacheHeader
+ *   joints   : [name length, name, pos, isEdge, parents, closest children]
+ *   channels : [joint ID, ChannelEnum] * numOfChannels
+ *   padding to MOTION_CACHE_FRAMES_ALIGNMENT
+ *   frames   : float * numOfFrames * numOfJoints * NUM_OF_JOINT_STATE_VALUES
+ */
+struct MotionCacheHeader {
+    char signature[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t sourceContentHash;
+
+    uint32_t numOfJoints;
+    uint32_t numOfChannels;
+    uint64_t numOfFrames;
+    float frameRate;
+    uint32_t rotationOrder[3];
+
+    uint64_t framesOffset;
+    uint64_t fileSize;
+};
+static_assert(std::is_trivially_copyable<MotionCacheHeader>::value);
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t hashBytes(const char *data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+std::runtime_error createBrokenCacheError(const std::filesystem::path &path) {
+    std::string msg;
+    msg += "Motion cache file '";
+    msg += path.string();
+    msg += "' is broken.";
+    return std::runtime_error(msg);
+}
+
+/// Append POD values to a byte buffer.
+class CacheWriter {
+    std::string &buffer;
+
+  public:
+    CacheWriter(std::string &buffer) : buffer(buffer) {}
+
+    template <typename T> void write(const T &value) {
+        static_assert(std::is_trivially_copyable<T>::value);
+        buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void writeIDs(const std::vector<ikura::GroupID> &ids) {
+        write(static_cast<uint32_t>(ids.size()));
+        for (auto id : ids) {
+            write(static_cast<uint32_t>(id));
+        }
+    }
+};
+
+/// Read POD values from mapped bytes with bounds checking.
+class CacheReader {
+    const char *cursor;
+    const char *end;
+    const std::filesystem::path &path;
+
+  public:
+    CacheReader(const char *begin, const char *end,
+                const std::filesystem::path &path)
+        : cursor(begin), end(end), path(path) {}
+
+    template <typename T> T read() {
+        static_assert(std::is_trivially_copyable<T>::value);
+        if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+            throw createBrokenCacheError(path);
+        }
+        T value;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+
+    std::string readString(size_t length) {
+        if (static_cast<size_t>(end - cursor) < length) {
+            throw createBrokenCacheError(path);
+        }
+        std::string str(cursor, length);
+        cursor += length;
+        return str;
+    }
+
+    std::vector<ikura::GroupID> readIDs(uint32_t numOfJoints) {
+        uint32_t size = read<uint32_t>();
+        if (size > numOfJoints) {
+            throw createBrokenCacheError(path);
+        }
+        std::vector<ikura::GroupID> ids(size);
+        for (auto &id : ids) {
+            id = read<uint32_t>();
+            if (id >= numOfJoints) {
+                throw createBrokenCacheError(path);
+            }
+        }
+        return ids;
+    }
+};
+} // namespace
+
+MotionCacheKey
+createMotionCacheKey(const std::filesystem::path &sourceFilePath) {
+    MotionCacheKey key{};
+
+    std::error_code ec;
+    auto modifiedTime = std::filesystem::last_write_time(sourceFilePath, ec);
+    if (ec) {
+        std::string msg;
+        msg += "Failed to get modified time of '";
+        msg += sourceFilePath.string();
+        msg += "'.";
+        throw std::runtime_error(msg);
+    }
+    key.sourceModifiedTime = modifiedTime.time_since_epoch().count();
+
+    // Hashing every byte would cost as much time as parsing, so the head,
+    // the tail and evenly spaced blocks in between are hashed.
+    // Edits that keep the size and mtime are expected to touch them.
+    MappedFile source(sourceFilePath);
+    const char *data = source.getData();
+    const size_t size = source.getSize();
+    key.sourceSize = size;
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    if (size <= 2 * CONTENT_HASH_EDGE_BLOCK_SIZE) {
+        hash = hashBytes(data, size, hash);
+    } else {
+        hash = hashBytes(data, CONTENT_HASH_EDGE_BLOCK_SIZE, hash);
+
+        const size_t innerSize = size - 2 * CONTENT_HASH_EDGE_BLOCK_SIZE;
+        for (size_t i = 0; i < CONTENT_HASH_NUM_OF_INNER_BLOCKS; i++) {
+            size_t offset = CONTENT_HASH_EDGE_BLOCK_SIZE +
+                            innerSize * i / CONTENT_HASH_NUM_OF_INNER_BLOCKS;
+            size_t blockSize = std::min<size_t>(
+                CONTENT_HASH_INNER_BLOCK_SIZE,
+                size - CONTENT_HASH_EDGE_BLOCK_SIZE - offset);
+            hash = hashBytes(data + offset, blockSize, hash);
+        }
+
+        hash = hashBytes(data + size - CONTENT_HASH_EDGE_BLOCK_SIZE,
+                         CONTENT_HASH_EDGE_BLOCK_SIZE, hash);
+    }
+    key.sourceContentHash = hash;
+
+    return key;
+}
+
+std::filesystem::path getMotionCacheDirectory() {
+    return getWritableResourceDirectory() / "motion_cache";
+}
+
+std::filesystem::path
+getMotionCacheFilePath(const std::filesystem::path &sourceFilePath) {
+    std::error_code ec;
+    auto absolutePath = std::filesystem::absolute(sourceFilePath, ec);
+    if (ec) {
+        absolutePath = sourceFilePath;
+    }
+    const std::string pathStr = absolutePath.lexically_normal().string();
+
+    char hashStr[17];
+    snprintf(hashStr, sizeof(hashStr), "%016llx",
+             static_cast<unsigned long long>(
+                 hashBytes(pathStr.data(), pathStr.size(), FNV_OFFSET_BASIS)));
+
+    return getMotionCacheDirectory() /
+           (std::string(hashStr) + MOTION_CACHE_EXTENSION);
+}
+
+void touchMotionCache(const std::filesystem::path &cacheFilePath) {
+    std::error_code ec;
+    std::filesystem::last_write_time(
+        cacheFilePath, std::filesystem::file_time_type::clock::now(), ec);
+}
+
+void evictMotionCaches(std::uintmax_t maxBytes,
+                       const std::filesystem::path &keepFilePath) {
+    struct CacheFile {
+        std::filesystem::path path;
+        std::uintmax_t size;
+        std::filesystem::file_time_type modifiedTime;
+    };
+    std::vector<CacheFile> cacheFiles;
+    std::uintmax_t totalSize = 0;
+
+    std::error_code ec;
+    std::filesystem::directory_iterator it(getMotionCacheDirectory(), ec);
+    for (; !ec && it != std::filesystem::directory_iterator();
+         it.increment(ec)) {
+        const auto &path = it->path();
+        if (path.extension() != MOTION_CACHE_EXTENSION ||
+            !it->is_regular_file(ec)) {
+            continue;
+        }
+
+        CacheFile cacheFile{path, it->file_size(ec), it->last_write_time(ec)};
+        if (ec) {
+            continue;
+        }
+        totalSize += cacheFile.size;
+        if (!std::filesystem::equivalent(path, keepFilePath, ec)) {
+            cacheFiles.push_back(cacheFile);
+        }
+    }
+
+    // least recently used first
+    std::sort(cacheFiles.begin(), cacheFiles.end(),
+              [](const CacheFile &a, const CacheFile &b) {
+                  return a.modifiedTime < b.modifiedTime;
+              });
+
+    for (const auto &cacheFile : cacheFiles) {
+        if (totalSize <= maxBytes) {
+            break;
+        }
+        if (std::filesystem::remove(cacheFile.path, ec)) {
+            totalSize -= cacheFile.size;
+        }
+    }
+}
+
+bool isMotionCacheFile(const std::filesystem::path &filePath) {
+    std::ifstream inputStream(filePath, std::ios::binary);
+    char signature[sizeof(MotionCacheHeader::signature)] = {};
+    inputStream.read(signature, sizeof(signature));
+
+    return inputStream.gcount() == sizeof(signature) &&
+           std::memcmp(signature, MOTION_CACHE_SIGNATURE,
+                       sizeof(MOTION_CACHE_SIGNATURE)) == 0;
+}
+
+bool writeMotionCache(
+    const std::filesystem::path &cacheFilePath, const MotionCacheKey &key,
+    const std::vector<std::shared_ptr<Animator::Joint>> &joints,
+    const Motion &motion, const BVHParseProgress *progress) {
+    std::string body;
+    CacheWriter writer(body);
+
+    // joints
+    for (const auto &joint : joints) {
+        const std::string name = joint->getName();
+        writer.write(static_cast<uint32_t>(name.size()));
+        body += name;
+        writer.write(joint->getPos());
+        writer.write(static_cast<uint8_t>(joint->getIsEdge()));
+        writer.writeIDs(joint->getParentIDs());
+        writer.writeIDs(joint->getClosestChildIDs());
+    }
+
+    // channels
+    for (const auto &correspondance : motion.channelDescriptionOrder) {
+        writer.write(static_cast<uint32_t>(correspondance.joindId));
+        writer.write(static_cast<uint32_t>(correspondance.channel));
+    }
+
+    const size_t framesSize =
+        motion.numOfFrames * motion.getFrameStride() * sizeof(float);
+    const size_t bodyEnd = sizeof(MotionCacheHeader) + body.size();
+    const size_t framesOffset =
+        (bodyEnd + MOTION_CACHE_FRAMES_ALIGNMENT - 1) /
+        MOTION_CACHE_FRAMES_ALIGNMENT * MOTION_CACHE_FRAMES_ALIGNMENT;
+    body.append(framesOffset - bodyEnd, '\0');
+
+    MotionCacheHeader header{};
+    std::memcpy(header.signature, MOTION_CACHE_SIGNATURE,
+                sizeof(MOTION_CACHE_SIGNATURE));
+    header.version = MOTION_CACHE_VERSION;
+    header.byteOrderMark = MOTION_CACHE_BYTE_ORDER_MARK;
+    header.sourceSize = key.sourceSize;
+    header.sourceModifiedTime = key.sourceModifiedTime;
+    header.sourceContentHash = key.sourceContentHash;
+    header.numOfJoints = static_cast<uint32_t>(joints.size());
+    header.numOfChannels =
+        static_cast<uint32_t>(motion.channelDescriptionOrder.size());
+    header.numOfFrames = motion.numOfFrames;
+    header.frameRate = motion.frameRate;
+    for (size_t i = 0; i < 3; i++) {
+        header.rotationOrder[i] = motion.rotationOrder[i];
+    }
+    header.framesOffset = framesOffset;
+    header.fileSize = framesOffset + framesSize;
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheFilePath.parent_path(), ec);
+
+    auto tmpFilePath = cacheFilePath;
+    tmpFilePath += ".tmp";
+    {
+        std::ofstream outputStream(tmpFilePath,
+                                   std::ios::binary | std::ios::trunc);
+        outputStream.write(reinterpret_cast<const char *>(&header),
+                           sizeof(header));
+        outputStream.write(body.data(), body.size());
+        // written frame by frame, frames may be decoded on demand
+        const size_t frameSize = motion.getFrameStride() * sizeof(float);
+        for (size_t frame = 0; frame < motion.numOfFrames; frame++) {
+            if (progress && progress->isCancelRequested()) {
+                outputStream.close();
+                std::filesystem::remove(tmpFilePath, ec);
+                return false;
+            }
+            outputStream.write(
+                reinterpret_cast<const char *>(motion.getFrameValues(frame)),
+                frameSize);
+        }
+
+        if (!outputStream) {
+            outputStream.close();
+            std::filesystem::remove(tmpFilePath, ec);
+
+            std::string msg;
+            msg += "Failed to write motion cache file '";
+            msg += tmpFilePath.string();
+            msg += "'.";
+            throw std::runtime_error(msg);
+        }
+    }
+
+    std::filesystem::rename(tmpFilePath, cacheFilePath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpFilePath, ec);
+
+        std::string msg;
+        msg += "Failed to rename motion cache file to '";
+        msg += cacheFilePath.string();
+        msg += "'.";
+        throw std::runtime_error(msg);
+    }
+
+    return true;
+}
+
+bool loadMotionCache(const std::filesystem::path &cacheFilePath,
+                     const MotionCacheKey *expectedKey,
+                     MotionCacheData &data) {
+    if (!MappedFile::isMappable(cacheFilePath)) {
+        return false;
+    }
+
+    auto cacheFile = std::make_shared<MappedFile>(cacheFilePath);
+    const char *begin = cacheFile->getData();
+
+    // header
+    MotionCacheHeader header;
+    if (cacheFile->getSize() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, begin, sizeof(header));
+
+    if (std::memcmp(header.signature, MOTION_CACHE_SIGNATURE,
+                    sizeof(MOTION_CACHE_SIGNATURE)) != 0 ||
+        header.version != MOTION_CACHE_VERSION ||
+        header.byteOrderMark != MOTION_CACHE_BYTE_ORDER_MARK) {
+        return false;
+    }
+
+    if (expectedKey && (header.sourceSize != expectedKey->sourceSize ||
+                        header.sourceModifiedTime !=
+                            expectedKey->sourceModifiedTime ||
+                        header.sourceContentHash !=
+                            expectedKey->sourceContentHash)) {
+        return false;
+    }
+
+    if (header.numOfJoints == 0 ||
+        header.numOfJoints > ikura::MAX_NUM_OF_MODEL_MATRIX ||
+        header.fileSize != cacheFile->getSize() ||
+        header.framesOffset % MOTION_CACHE_FRAMES_ALIGNMENT != 0 ||
+        header.framesOffset > header.fileSize ||
+        (header.fileSize - header.framesOffset) / sizeof(float) /
+                (header.numOfJoints * NUM_OF_JOINT_STATE_VALUES) !=
+            header.numOfFrames) {
+        throw createBrokenCacheError(cacheFilePath);
+    }
+
+    CacheReader reader(begin + sizeof(header), begin + header.framesOffset,
+                       cacheFilePath);
+
+    // joints
+    std::vector<std::shared_ptr<Animator::Joint>> joints;
+    for (uint32_t id = 0; id < header.numOfJoints; id++) {
+        std::string name = reader.readString(reader.read<uint32_t>());
+        glm::vec3 pos = reader.read<glm::vec3>();
+        bool isEdge = reader.read<uint8_t>() != 0;
+        auto parentIDs = reader.readIDs(header.numOfJoints);
+        auto closestChildIDs = reader.readIDs(header.numOfJoints);
+
+        auto joint = std::make_shared<Animator::Joint>(name, id, pos,
+                                                       parentIDs, isEdge);
+        joint->setClosestChildIDs(closestChildIDs);
+        joints.push_back(joint);
+    }
+
+    // motion
+    auto motion = std::make_shared<Motion>();
+    motion->frameRate = header.frameRate;
+    motion->numOfSourceFrames = header.numOfFrames;
+    for (size_t i = 0; i < 3; i++) {
+        if (header.rotationOrder[i] > RotationAxisEnum::Z) {
+            throw createBrokenCacheError(cacheFilePath);
+        }
+        motion->rotationOrder[i] =
+            static_cast<RotationAxisEnum>(header.rotationOrder[i]);
+    }
+
+    motion->ownedChannels.resize(header.numOfJoints);
+    for (uint32_t i = 0; i < header.numOfChannels; i++) {
+        ChannelJointCorrespondance correspondance{};
+        correspondance.joindId = reader.read<uint32_t>();
+        uint32_t channel = reader.read<uint32_t>();
+        if (correspondance.joindId >= header.numOfJoints ||
+            channel > ChannelEnum::Zrotation) {
+            throw createBrokenCacheError(cacheFilePath);
+        }
+        correspondance.channel = static_cast<ChannelEnum>(channel);
+
+        motion->channelDescriptionOrder.push_back(correspondance);
+        motion->ownedChannels[correspondance.joindId].insert(
+            correspondance.channel);
+    }
+
+    motion->attachExternalFrames(
+        cacheFile,
+        reinterpret_cast<const float *>(begin + header.framesOffset),
+        header.numOfJoints, header.numOfFrames);
+
+    data.joints = std::move(joints);
+    data.motion = std::move(motion);
+
+    return true;
+}
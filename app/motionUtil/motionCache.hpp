@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "./animator.hpp"
+#include "./bvhParserConfig.hpp"
+#include "./common.hpp"
+
+#define MOTION_CACHE_EXTENSION ".imvmotion"
+// max total size of cache files in the motion cache directory
+#define MOTION_CACHE_DIRECTORY_MAX_BYTES (2ULL * 1024 * 1024 * 1024)
+
+/**
+ * @brief Identifies the .bvh file a motion cache was created from.
+ *
+ * A cache is valid only if all members match the current source file.
+ */
+struct MotionCacheKey {
+    uint64_t sourceSize = 0;
+    int64_t sourceModifiedTime = 0;
+    /// Hash of sampled blocks of the source file (see createMotionCacheKey).
+    uint64_t sourceContentHash = 0;
+};
+
+/**
+ * @brief Skeleton and Motion loaded from a motion cache file.
+ *
+ * Frame values of `motion` point into the memory-mapped cache file, which
+ * stays mapped as long as `motion` is alive.
+ */
+struct MotionCacheData {
+    std::vector<std::shared_ptr<Animator::Joint>> joints;
+    std::shared_ptr<Motion> motion;
+};
+
+/// Create the key of `sourceFilePath` from its size, mtime and content.
+/// Throws std::runtime_error if the file cannot be read.
+MotionCacheKey createMotionCacheKey(const std::filesystem::path &sourceFilePath);
+
+/// Directory of motion cache files in the writable resource directory.
+std::filesystem::path getMotionCacheDirectory();
+
+/// Path of the cache file of `sourceFilePath` in the motion cache directory.
+/// The file may not exist.
+std::filesystem::path
+getMotionCacheFilePath(const std::filesystem::path &sourceFilePath);
+
+/// Mark the cache file as recently used, so it is evicted last.
+void touchMotionCache(const std::filesystem::path &cacheFilePath);
+
+/**
+ * @brief Remove least recently used cache files (by mtime) until the total
+ * size of the motion cache directory is at most `maxBytes`.
+ *
+ * `keepFilePath` is never removed. Failures to remove files are ignored.
+ */
+void evictMotionCaches(std::uintmax_t maxBytes,
+                       const std::filesystem::path &keepFilePath);
+
+/// Return true if `filePath` starts with the motion cache signature.
+bool isMotionCacheFile(const std::filesystem::path &filePath);
+
+/**
+ * @brief Write joints and motion to a motion cache file.
+ *
+ * The file is written to a temporary file first and renamed, so a reader
+ * never sees a partially written cache.
+ * Throws std::runtime_error on failure.
+ *
+ * @param progress if not nullptr, writing stops when cancel is requested.
+ * @return false if cancelled. The temporary file is removed.
+ */
+bool writeMotionCache(const std::filesystem::path &cacheFilePath,
+                      const MotionCacheKey &key,
+                      const std::vector<std::shared_ptr<Animator::Joint>> &joints,
+                      const Motion &motion,
+                      const BVHParseProgress *progress = nullptr);
+
+/**
+ * @brief Memory-map a motion cache file and restore joints and motion.
+ *
+ * @param expectedKey if not nullptr, the cache is rejected unless its key
+ * equals `*expectedKey`. Pass nullptr to open the cache as a standalone file.
+ * @return false if the file does not exist, is from another version of the
+ * format or does not match `expectedKey`.
+ * Throws std::runtime_error if the file is broken.
+ */
+bool loadMotionCache(const std::filesystem::path &cacheFilePath,
+                     const MotionCacheKey *expectedKey, MotionCacheData &data);
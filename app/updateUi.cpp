@@ -39,6 +39,9 @@ void App::updateUI() {
     if (ui->showImGuiDemoWindow) {
         ImGui::ShowDemoWindow();
     }
+    if (isLoadingModel()) {
+        updateLoadingWindow();
+    }
 
     ImGui::Render();
 }
@@ -91,6 +94,43 @@ void App::updateMainMenu() {
                 ImGui::EndDisabled();
             }
 
+            // Loading Option --------------------
+            ImGui::Checkbox(u8"フレームを必要な時に読み込む",
+                            &ui->config.lazyMotionLoading);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip(u8"巨大なBVHファイルを素早く開けますが、"
+                                  u8"シーク時にフレームを読み込みます。");
+            }
+
+            ImGui::Checkbox(u8"フレーム範囲を指定して読み込む",
+                            &ui->config.loadFrameRange);
+            if (!ui->config.loadFrameRange) {
+                ImGui::BeginDisabled();
+            }
+            ImGui::PushItemWidth(120);
+            ImGui::InputInt(u8"開始フレーム##load_first_frame",
+                            &ui->config.loadFirstFrameNum);
+            ImGui::InputInt(u8"終了フレーム##load_last_frame",
+                            &ui->config.loadLastFrameNum);
+            ImGui::InputInt(u8"間隔##load_frame_step",
+                            &ui->config.loadFrameStep);
+            ImGui::PopItemWidth();
+            ui->config.loadFirstFrameNum =
+                std::max(ui->config.loadFirstFrameNum, 1);
+            ui->config.loadLastFrameNum = std::max(
+                ui->config.loadLastFrameNum, ui->config.loadFirstFrameNum);
+            ui->config.loadFrameStep = std::max(ui->config.loadFrameStep, 1);
+            if (!ui->config.loadFrameRange) {
+                ImGui::EndDisabled();
+            }
+
+            ImGui::Checkbox(u8"全フレームの姿勢を事前計算する",
+                            &ui->config.bakeJointMatrices);
+            if (ImGui::IsItemHovered()) {
+                ImGui::SetTooltip(u8"再生時の計算を省きますが、"
+                                  u8"メモリを多く使用します。");
+            }
+
             // Export Option --------------------
             ImGui::Checkbox(u8"全てのPositionチャンネルをエクスポート",
                             &ui->config.exportAllPositionChannel);
@@ -120,6 +160,8 @@ void updateAnimationControlWindowSpeedController(
     std::shared_ptr<Animator> animator);
 void updateAnimationControlWindowEditor(bool &modelLoaded,
                                         std::shared_ptr<Animator> animator);
+void showSourceFrameNum(const std::shared_ptr<Animator> &animator,
+                        int frameNum);
 
 void App::updateAnimationControlWindow() {
     if (!ui->animationControlWindow.windowInitialized) {
@@ -236,6 +278,15 @@ void updateAnimationControlWindowSeekbar(UI::AnimationControlWindow &ctx,
 
     if (modelLoaded) {
         ImGui::Text("Frame: %d / %d", currentFrameNum, maxFrameNum);
+
+        // frame numbering of the source file if a part of it is loaded
+        if (animator->getNumOfSourceFrames() != maxFrameNum) {
+            ImGui::SameLine();
+            ImGui::TextDisabled(
+                u8"(元ファイル: %d / %d)",
+                animator->getSourceFrameIndex(currentFrameNum - 1) + 1,
+                animator->getNumOfSourceFrames());
+        }
     } else {
         ImGui::Text("Frame: -- / --");
     }
@@ -370,6 +421,7 @@ void updateAnimationControlWindowEditor(bool &modelLoaded,
         ImGui::PushItemWidth(100);
         ImGui::InputInt("##editor_start_input", &newLoopStartFrameNum);
         ImGui::PopItemWidth();
+        showSourceFrameNum(animator, newLoopStartFrameNum);
 
         ImGui::PushItemWidth(-1);
         ImGui::SliderInt("##editor_start", &newLoopStartFrameNum, 1,
@@ -386,6 +438,7 @@ void updateAnimationControlWindowEditor(bool &modelLoaded,
         ImGui::PushItemWidth(100);
         ImGui::InputInt("##editor_end_input", &newLoopEndFrameNum);
         ImGui::PopItemWidth();
+        showSourceFrameNum(animator, newLoopEndFrameNum);
 
         ImGui::PushItemWidth(-1);
         ImGui::SliderInt("##editor_end", &newLoopEndFrameNum, 1,
@@ -413,6 +466,24 @@ void updateAnimationControlWindowEditor(bool &modelLoaded,
     }
 }
 
+/**
+ * @brief 一部のフレームのみ読み込んだ場合、元ファイルでのフレーム番号を表示する。
+ *
+ * @param frameNum 読み込んだフレームの番号 (1から始まる)
+ */
+void showSourceFrameNum(const std::shared_ptr<Animator> &animator,
+                        int frameNum) {
+    if (animator->getNumOfSourceFrames() == animator->getNumOfFrames()) {
+        return;
+    }
+
+    uint32_t frameIndex = std::clamp(frameNum - 1, 0,
+                                     (int)animator->getNumOfFrames() - 1);
+    ImGui::SameLine();
+    ImGui::TextDisabled(u8"(元ファイル: %d)",
+                        animator->getSourceFrameIndex(frameIndex) + 1);
+}
+
 // ----------------------------------------
 // Debug window
 // ----------------------------------------
@@ -431,6 +502,8 @@ void App::updateDebugWindow() {
     ImGui::Checkbox(u8"軸オブジェクトを表示する##show_axis_object",
                     &ui->showAxisObject);
     ImGui::Checkbox(u8"床を表示する##show_floor", &ui->showFloor);
+    ImGui::Checkbox(u8"視錐台カリングを有効化する##enable_frustum_culling",
+                    &ui->enableFrustumCulling);
     // ImGui::Checkbox("垂直同期を有効化する##enable_vsinc", &ui->enableVsinc);
 
     UI::makePadding(20);
@@ -441,6 +514,20 @@ void App::updateDebugWindow() {
 
     UI::makePadding(10);
 
+    // culling status
+    const auto &cullingStatistics = mainRenderContent->getCullingStatistics();
+    ImGui::Text("Drawn instances: %u / %u",
+                cullingStatistics.numOfInstances -
+                    cullingStatistics.numOfHiddenInstances -
+                    cullingStatistics.numOfCulledInstances,
+                cullingStatistics.numOfInstances);
+    ImGui::Text("Culled / Hidden instances: %u / %u",
+                cullingStatistics.numOfCulledInstances,
+                cullingStatistics.numOfHiddenInstances);
+    ImGui::Text("Draw commands: %u", cullingStatistics.numOfDrawCommands);
+
+    UI::makePadding(10);
+
     // mouse input status
     ImGui::Text("Cursor Pos: (%.1f, %.1f)", mouse->currentX, mouse->currentY);
     ImGui::Text("DragStart: (%.1f, %.1f)", mouse->dragStartX,
@@ -472,3 +559,50 @@ void App::updateDebugWindow() {
 
     ImGui::End();
 }
+
+// ----------------------------------------
+// Loading window
+// ----------------------------------------
+
+void App::updateLoadingWindow() {
+    // 画面中央に表示する
+    const ImVec2 center = ImGui::GetMainViewport()->GetCenter();
+    ImGui::SetNextWindowPos(center, ImGuiCond_Appearing, ImVec2(0.5f, 0.5f));
+    ImGui::SetNextWindowSize(ImVec2(500, 0), ImGuiCond_Appearing);
+
+    ImGui::Begin(u8"読み込み中", nullptr,
+                 ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize);
+
+    ImGui::TextWrapped("%s", loadingFilePath.c_str());
+    UI::makePadding(10);
+
+    const auto toFraction = [](size_t done, size_t total) {
+        return total > 0 ? static_cast<float>(done) / total : 0.0f;
+    };
+
+    // ファイルの走査 (バイト単位)
+    const size_t totalBytes = loadingProgress->numOfTotalBytes;
+    const size_t scannedBytes = loadingProgress->numOfScannedBytes;
+    ImGui::Text(u8"走査: %.1f / %.1f MB", scannedBytes / (1024.0 * 1024.0),
+                totalBytes / (1024.0 * 1024.0));
+    ImGui::ProgressBar(toFraction(scannedBytes, totalBytes), ImVec2(-1, 0));
+
+    // フレームのデコード (フレーム単位)
+    const size_t totalFrames = loadingProgress->numOfTotalFrames;
+    const size_t decodedFrames = loadingProgress->numOfDecodedFrames;
+    ImGui::Text(u8"フレーム: %zu / %zu", decodedFrames, totalFrames);
+    ImGui::ProgressBar(toFraction(decodedFrames, totalFrames), ImVec2(-1, 0));
+
+    UI::makePadding(10);
+
+    if (loadingProgress->isCancelRequested()) {
+        ImGui::BeginDisabled();
+        ImGui::Button(u8"キャンセル中...");
+        ImGui::EndDisabled();
+    } else if (ImGui::Button(u8"キャンセル")) {
+        // 読み込みスレッドの終了はswapLoadedModel()で待つ
+        loadingProgress->cancelRequested = true;
+    }
+
+    ImGui::End();
+}
@@ -0,0 +1,137 @@
+#include "./mappedFile.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#ifdef IS_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+std::runtime_error createMapError(const std::string &what,
+                                  const std::filesystem::path &filePath) {
+    std::string msg;
+    msg += "Failed to ";
+    msg += what;
+    msg += " '";
+    msg += filePath.string();
+    msg += "'.";
+    return std::runtime_error(msg);
+}
+} // namespace
+
+#ifdef IS_WINDOWS
+
+MappedFile::MappedFile(const std::filesystem::path &filePath) {
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw createMapError("open", filePath);
+    }
+    fileHandle = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        release();
+        throw createMapError("get size of", filePath);
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    // zero-length files cannot be mapped
+    if (size == 0) {
+        return;
+    }
+
+    HANDLE mapping =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        release();
+        throw createMapError("create file mapping of", filePath);
+    }
+    mappingHandle = mapping;
+
+    data = static_cast<const char *>(
+        MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        release();
+        throw createMapError("map", filePath);
+    }
+}
+
+void MappedFile::release() {
+    if (data) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (mappingHandle) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        mappingHandle = nullptr;
+    }
+    if (fileHandle) {
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        fileHandle = nullptr;
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path &filePath) {
+    fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        throw createMapError("open", filePath);
+    }
+
+    struct stat fileStat;
+    if (fstat(fileDescriptor, &fileStat) != 0) {
+        release();
+        throw createMapError("get size of", filePath);
+    }
+    size = static_cast<size_t>(fileStat.st_size);
+
+    // zero-length files cannot be mapped
+    if (size == 0) {
+        return;
+    }
+
+    void *mapped =
+        mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapped == MAP_FAILED) {
+        release();
+        throw createMapError("map", filePath);
+    }
+    data = static_cast<const char *>(mapped);
+
+    // the whole file is read front to back
+    madvise(mapped, size, MADV_SEQUENTIAL);
+}
+
+void MappedFile::release() {
+    if (data) {
+        munmap(const_cast<char *>(data), size);
+        data = nullptr;
+    }
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+}
+
+#endif
+
+MappedFile::~MappedFile() { release(); }
+
+const char *MappedFile::getData() const { return data; }
+
+size_t MappedFile::getSize() const { return size; }
+
+bool MappedFile::isMappable(const std::filesystem::path &filePath) {
+    std::error_code ec;
+    return std::filesystem::is_regular_file(filePath, ec);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+/**
+ * @brief Read-only memory mapping of a whole regular file.
+ *
+ * The file is mapped in the constructor and unmapped in the destructor.
+ * Mapped bytes are NOT null-terminated.
+ */
+class MappedFile {
+    const char *data = nullptr;
+    size_t size = 0;
+
+#ifdef IS_WINDOWS
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+    void release();
+
+  public:
+    /// Throws std::runtime_error if the file cannot be opened or mapped.
+    MappedFile(const std::filesystem::path &filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *getData() const;
+    size_t getSize() const;
+
+    /// Return true if `filePath` points to a regular file that can be mapped.
+    /// Pipes, character devices etc. have to be read through a stream.
+    static bool isMappable(const std::filesystem::path &filePath);
+};
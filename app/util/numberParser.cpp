@@ -0,0 +1,122 @@
+#include "./numberParser.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+namespace {
+// max number of significant digits held in uint64_t without overflow
+constexpr int MAX_MANTISSA_DIGITS = 19;
+// mantissa below 2^53 and |exponent| <= 22 can be scaled exactly in double
+constexpr uint64_t MAX_EXACT_MANTISSA = (uint64_t(1) << 53);
+constexpr int MAX_EXACT_EXPONENT = 22;
+
+constexpr double EXACT_POWERS_OF_TEN[MAX_EXACT_EXPONENT + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+} // namespace
+
+const char *parseFloat(const char *first, const char *last, float &value) {
+    const char *p = first;
+
+    bool negative = false;
+    if (p < last && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int numOfMantissaDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    // integer part
+    for (; p < last && isDigit(*p); p++) {
+        hasDigits = true;
+        if (numOfMantissaDigits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            if (mantissa > 0) {
+                numOfMantissaDigits++;
+            }
+        } else {
+            exponent++;
+        }
+    }
+
+    // fraction part
+    if (p < last && *p == '.') {
+        p++;
+        for (; p < last && isDigit(*p); p++) {
+            hasDigits = true;
+            if (numOfMantissaDigits < MAX_MANTISSA_DIGITS) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                if (mantissa > 0) {
+                    numOfMantissaDigits++;
+                }
+                exponent--;
+            }
+        }
+    }
+
+    if (!hasDigits) {
+        return nullptr;
+    }
+
+    // exponent part (only consumed if it is well-formed)
+    if (p < last && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool negativeExponent = false;
+        if (q < last && (*q == '-' || *q == '+')) {
+            negativeExponent = (*q == '-');
+            q++;
+        }
+        if (q < last && isDigit(*q)) {
+            int explicitExponent = 0;
+            for (; q < last && isDigit(*q); q++) {
+                // far beyond float range, just avoid overflow
+                if (explicitExponent < 10000) {
+                    explicitExponent = explicitExponent * 10 + (*q - '0');
+                }
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            p = q;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (mantissa != 0) {
+        if (mantissa <= MAX_EXACT_MANTISSA && exponent >= -MAX_EXACT_EXPONENT &&
+            exponent <= MAX_EXACT_EXPONENT) {
+            // single correctly rounded operation
+            result = exponent < 0 ? result / EXACT_POWERS_OF_TEN[-exponent]
+                                  : result * EXACT_POWERS_OF_TEN[exponent];
+        } else {
+            result *= std::pow(10.0, exponent);
+        }
+    }
+
+    // out of the range of float
+    const float floatResult = static_cast<float>(negative ? -result : result);
+    if (!std::isfinite(floatResult)) {
+        return nullptr;
+    }
+
+    value = floatResult;
+    return p;
+}
+
+const char *parseSize(const char *first, const char *last, size_t &value) {
+    const char *p = first;
+
+    value = 0;
+    for (; p < last && isDigit(*p); p++) {
+        const size_t digit = static_cast<size_t>(*p - '0');
+        if (value > (SIZE_MAX - digit) / 10) {
+            return nullptr;
+        }
+        value = value * 10 + digit;
+    }
+
+    return p == first ? nullptr : p;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Locale-independent decimal float parser.
+ *
+ * Parses `[+-]digits[.digits][(e|E)[+-]digits]` from [first, last) like
+ * std::from_chars, without allocation and without a null terminator.
+ *
+ * @return pointer to the first character not consumed, or nullptr if
+ * [first, last) does not start with a number or the value is out of the
+ * range of float.
+ */
+const char *parseFloat(const char *first, const char *last, float &value);
+
+/**
+ * @brief Locale-independent unsigned integer parser.
+ *
+ * @return pointer to the first character not consumed, or nullptr if
+ * [first, last) does not start with a digit or the value overflows size_t.
+ */
+const char *parseSize(const char *first, const char *last, size_t &value);
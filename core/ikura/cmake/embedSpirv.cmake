@@ -0,0 +1,37 @@
+# Writes a SPIR-V binary as a constexpr uint32_t array in a C++ header.
+#
+# usage: cmake -DSPIRV_FILE=<in.spv> -DOUTPUT_FILE=<out.hpp>
+#              -DVARIABLE_NAME=<name> -P embedSpirv.cmake
+
+file(READ ${SPIRV_FILE} spirv_hex HEX)
+string(LENGTH "${spirv_hex}" spirv_hex_length)
+math(EXPR spirv_remainder "${spirv_hex_length} % 8")
+if (spirv_hex_length EQUAL 0 OR NOT spirv_remainder EQUAL 0)
+    message(FATAL_ERROR "${SPIRV_FILE} is not a valid SPIR-V binary.")
+endif ()
+
+# SPIR-V words are stored in little endian by glslang
+string(REGEX REPLACE
+        "(..)(..)(..)(..)" "0x\\4\\3\\2\\1,"
+        spirv_words "${spirv_hex}")
+# 8 words per line
+string(REPEAT "0x........," 8 spirv_line_pattern)
+string(REGEX REPLACE
+        "(${spirv_line_pattern})" "\\1\n    "
+        spirv_words "${spirv_words}")
+
+get_filename_component(spirv_source_name ${SPIRV_FILE} NAME)
+file(WRITE ${OUTPUT_FILE}
+        "// Generated from ${spirv_source_name} by embedSpirv.cmake. "
+        "Do not edit.\n"
+        "#pragma once\n"
+        "\n"
+        "#include <cstdint>\n"
+        "\n"
+        "namespace ikura {\n"
+        "namespace shaders {\n"
+        "constexpr uint32_t ${VARIABLE_NAME}[] = {\n"
+        "    ${spirv_words}\n"
+        "};\n"
+        "} // namespace shaders\n"
+        "} // namespace ikura\n")
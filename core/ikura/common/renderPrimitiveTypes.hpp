@@ -1,33 +1,70 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
 #include <vulkan/vulkan.hpp>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_precision.hpp>
 
 namespace ikura {
 
 class Vertex {};
 
+/**
+ * @brief Vertex of the basic pipeline, stored in the packed format read by
+ * the device (20 bytes, or 16 bytes with half precision positions).
+ *
+ * The position is full precision unless IKURA_HALF_PRECISION_VERTEX_POSITION
+ * is defined, which suits only meshes built around the origin and scaled by
+ * instances. The GroupID is added to the one of the instance, so it is the
+ * group within a mesh and must fit 16 bits.
+ */
 class BasicVertex : public Vertex {
   public:
     struct Data {
+#if defined(IKURA_HALF_PRECISION_VERTEX_POSITION)
+        // half precision, w is 1
+        glm::u16vec4 pos;
+#else
         glm::vec3 pos;
-        glm::vec3 color;
-        uint32_t id;
+#endif
+        // RGBA8 unorm
+        glm::u8vec4 color;
+        uint16_t id;
+        uint16_t padding;
     } data;
 
     BasicVertex(glm::vec3 pos, glm::vec3 color, uint32_t id) {
+        if (id > UINT16_MAX) {
+            std::string msg;
+            msg += "GroupID of BasicVertex must be at most ";
+            msg += std::to_string(UINT16_MAX);
+            msg += ", but ";
+            msg += std::to_string(id);
+            msg += " is given.";
+            throw std::runtime_error(msg);
+        }
+#if defined(IKURA_HALF_PRECISION_VERTEX_POSITION)
+        data.pos = glm::packHalf(glm::vec4(pos, 1.0f));
+#else
         data.pos = pos;
-        data.color = color;
-        data.id = id;
+#endif
+        data.color = glm::packUnorm<uint8_t>(glm::vec4(color, 1.0f));
+        data.id = static_cast<uint16_t>(id);
+        data.padding = 0;
     }
-    BasicVertex(const BasicVertex &basicVertex) {
-        Data newData;
-        newData.pos = basicVertex.data.pos;
-        newData.color = basicVertex.data.color;
-        newData.id = basicVertex.data.id;
 
-        data = newData;
+    glm::vec3 getPos() const {
+#if defined(IKURA_HALF_PRECISION_VERTEX_POSITION)
+        return glm::vec3(glm::unpackHalf(data.pos));
+#else
+        return data.pos;
+#endif
     }
 
     static vk::VertexInputBindingDescription getBindingDescription() {
@@ -45,38 +82,88 @@ class BasicVertex : public Vertex {
             3);
         attributeDescriptions[0].binding = 0;
         attributeDescriptions[0].location = 0;
+#if defined(IKURA_HALF_PRECISION_VERTEX_POSITION)
+        attributeDescriptions[0].format = vk::Format::eR16G16B16A16Sfloat;
+#else
         attributeDescriptions[0].format = vk::Format::eR32G32B32Sfloat;
+#endif
         attributeDescriptions[0].offset = offsetof(Data, pos);
 
         attributeDescriptions[1].binding = 0;
         attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = vk::Format::eR32G32B32Sfloat;
+        attributeDescriptions[1].format = vk::Format::eR8G8B8A8Unorm;
         attributeDescriptions[1].offset = offsetof(Data, color);
 
         attributeDescriptions[2].binding = 0;
         attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = vk::Format::eR32Uint;
+        attributeDescriptions[2].format = vk::Format::eR16Uint;
         attributeDescriptions[2].offset = offsetof(Data, id);
 
         return attributeDescriptions;
     }
 
-    static std::vector<Data>
-    convertToDataVector(std::vector<BasicVertex> vertices) {
-        std::vector<Data> dataVec(vertices.size());
+    bool operator==(const BasicVertex &other) const {
+        return (data.pos == other.data.pos && data.color == other.data.color &&
+                data.id == other.data.id);
+    }
+};
+// vectors of BasicVertex are uploaded as they are
+static_assert(sizeof(BasicVertex) == sizeof(BasicVertex::Data));
+#if defined(IKURA_HALF_PRECISION_VERTEX_POSITION)
+static_assert(sizeof(BasicVertex::Data) == 16);
+#else
+static_assert(sizeof(BasicVertex::Data) == 20);
+#endif
+
+/**
+ * @brief Per-instance data of the basic pipeline.
+ *
+ * Vertices of an instance are scaled by `offsetScale.w`, moved by
+ * `offsetScale.xyz` and transformed by the model matrix of
+ * (GroupID of the vertex + `id`), so one mesh built around the origin can be
+ * drawn for many groups.
+ */
+class BasicInstance {
+  public:
+    struct Data {
+        glm::vec4 offsetScale;
+        uint32_t id;
+    } data;
 
-        for (int i = 0; i < vertices.size(); i++) {
-            dataVec[i] = vertices[i].data;
-        }
+    BasicInstance(uint32_t id, glm::vec3 offset = glm::vec3(0.0),
+                  float scale = 1.0f) {
+        data.offsetScale = glm::vec4(offset, scale);
+        data.id = id;
+    }
+
+    static vk::VertexInputBindingDescription getBindingDescription() {
+        vk::VertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = 1;
+        bindingDescription.stride = sizeof(BasicInstance);
+        bindingDescription.inputRate = vk::VertexInputRate::eInstance;
 
-        return dataVec;
+        return bindingDescription;
     }
 
-    bool operator==(const BasicVertex &other) const {
-        return (data.pos == other.data.pos && data.color == other.data.color &&
-                data.id == other.data.id);
+    static std::vector<vk::VertexInputAttributeDescription>
+    getAttributeDescriptions() {
+        std::vector<vk::VertexInputAttributeDescription> attributeDescriptions(
+            2);
+        attributeDescriptions[0].binding = 1;
+        attributeDescriptions[0].location = 3;
+        attributeDescriptions[0].format = vk::Format::eR32G32B32A32Sfloat;
+        attributeDescriptions[0].offset = offsetof(Data, offsetScale);
+
+        attributeDescriptions[1].binding = 1;
+        attributeDescriptions[1].location = 4;
+        attributeDescriptions[1].format = vk::Format::eR32Uint;
+        attributeDescriptions[1].offset = offsetof(Data, id);
+
+        return attributeDescriptions;
     }
 };
+// vectors of BasicInstance are uploaded as they are
+static_assert(sizeof(BasicInstance) == sizeof(BasicInstance::Data));
 
 typedef uint32_t Index;
 typedef Index BasicIndex;
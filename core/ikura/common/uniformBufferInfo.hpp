@@ -1,16 +1,25 @@
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 namespace ikura {
-const int NUM_OF_MODEL_MATRIX = 256;
+/// Max number of model matrices, bounded by the smallest maxStorageBufferRange
+/// a Vulkan device can have (2^27 bytes).
+const uint32_t MAX_NUM_OF_MODEL_MATRIX = (1u << 27) / sizeof(glm::mat4);
 
-struct BasicModelMatUBO {
-    alignas(16) glm::mat4 model[NUM_OF_MODEL_MATRIX];
+/// Model matrix of each group, [GroupID].
+/// Only the matrices in `model` are uploaded.
+struct BasicModelMatSSBO {
+    std::vector<glm::mat4> model;
 };
 
-struct BasicSceneMatUBO {
+/// Pushed as push constants, which are guaranteed to hold 128 bytes.
+struct BasicSceneMatPushConstant {
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
 };
+static_assert(sizeof(BasicSceneMatPushConstant) <= 128);
 } // namespace ikura
\ No newline at end of file
@@ -83,8 +83,13 @@ void RenderEngine::createDevice() {
     deviceCI.queueCreateInfoCount = static_cast<uint32_t>(queueCI.size());
 
     // PhysicalDevice Feature ----------
+    auto supportedFeatures = physicalDevice.getFeatures();
     vk::PhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // optional, indirect draws are issued one by one or directly without them
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance =
+        supportedFeatures.drawIndirectFirstInstance;
 
     deviceCI.pEnabledFeatures = &deviceFeatures;
 
@@ -105,9 +110,24 @@ void RenderEngine::createDevice() {
         queueFamilyIndices.get(QueueFamilyIndices::GRAPHICS), 0);
     queues.presentQueue =
         device.getQueue(queueFamilyIndices.get(QueueFamilyIndices::PRESENT), 0);
+    uint32_t transferQueueFamilyIndex =
+        queueFamilyIndices.has(QueueFamilyIndices::TRANSFER)
+            ? queueFamilyIndices.get(QueueFamilyIndices::TRANSFER)
+            : queueFamilyIndices.get(QueueFamilyIndices::GRAPHICS);
+    queues.transferQueue = device.getQueue(transferQueueFamilyIndex, 0);
 
     // set RenderEngineInfo
     engineInfo.limit.maxMsaaSamples = GetMaxMsaaSamples(physicalDevice);
+    auto deviceLimits = physicalDevice.getProperties().limits;
+    engineInfo.limit.minUniformBufferOffsetAlignment =
+        deviceLimits.minUniformBufferOffsetAlignment;
+    engineInfo.limit.minStorageBufferOffsetAlignment =
+        deviceLimits.minStorageBufferOffsetAlignment;
+    engineInfo.limit.maxDrawIndirectCount = deviceLimits.maxDrawIndirectCount;
+    engineInfo.support.isMultiDrawIndirectSupported =
+        supportedFeatures.multiDrawIndirect == VK_TRUE;
+    engineInfo.support.isDrawIndirectFirstInstanceSupported =
+        supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
 
     // Initialize Vulkan Memory Allocator
     VmaAllocatorCreateInfo allocatorCI{};
@@ -137,6 +157,15 @@ void RenderEngine::createDevice() {
     cmdPool = device.createCommandPool(cmdPoolCI, nullptr);
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "CommandPool has been created.";
 
+    // Create PipelineCache
+    createPipelineCache();
+
+    // Create UploadManager
+    uploadManager = std::make_unique<UploadManager>(
+        device, *vmaAllocator, queues.transferQueue, transferQueueFamilyIndex,
+        queues.graphicsQueue,
+        queueFamilyIndices.get(QueueFamilyIndices::GRAPHICS));
+
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Vulkan Device has been created.";
 }
 
@@ -200,21 +229,30 @@ QueueFamilyIndices FindQueueFamilies(vk::PhysicalDevice device,
     auto families = device.getQueueFamilyProperties();
 
     uint32_t index = 0;
+    bool isTransferOnly = false;
     for (const auto &prop : families) {
-        // graphic family
-        if (prop.queueFlags & vk::QueueFlagBits::eGraphics) {
-            result.set(QueueFamilyIndices::GRAPHICS, index);
+        if (!result.isComplete()) {
+            // graphic family
+            if (prop.queueFlags & vk::QueueFlagBits::eGraphics) {
+                result.set(QueueFamilyIndices::GRAPHICS, index);
+            }
+
+            // present family
+            vk::Bool32 presentSupport = VK_FALSE;
+            presentSupport = device.getSurfaceSupportKHR(index, sampleSurface);
+            if (presentSupport) {
+                result.set(QueueFamilyIndices::PRESENT, index);
+            }
         }
 
-        // present family
-        vk::Bool32 presentSupport = VK_FALSE;
-        presentSupport = device.getSurfaceSupportKHR(index, sampleSurface);
-        if (presentSupport) {
-            result.set(QueueFamilyIndices::PRESENT, index);
+        // dedicated transfer family, preferring one without compute
+        if ((prop.queueFlags & vk::QueueFlagBits::eTransfer) &&
+            !(prop.queueFlags & vk::QueueFlagBits::eGraphics) &&
+            !isTransferOnly) {
+            result.set(QueueFamilyIndices::TRANSFER, index);
+            isTransferOnly = !(prop.queueFlags & vk::QueueFlagBits::eCompute);
         }
 
-        if (result.isComplete())
-            break;
         index++;
     }
 
@@ -0,0 +1,142 @@
+#include "./renderEngine.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <easylogging++.h>
+
+#include "../../common/logLevels.hpp"
+
+namespace ikura {
+namespace {
+// Layout of VkPipelineCacheHeaderVersionOne
+constexpr size_t PIPELINE_CACHE_HEADER_SIZE = 16 + VK_UUID_SIZE;
+
+/**
+ * @brief Check that `data` starts with a pipeline cache header created by the
+ * same device. Some drivers do not validate the header themselves.
+ */
+bool isPipelineCacheCompatible(const std::vector<char> &data,
+                               const vk::PhysicalDeviceProperties &props) {
+    if (data.size() < PIPELINE_CACHE_HEADER_SIZE) {
+        return false;
+    }
+
+    uint32_t header[4];
+    std::memcpy(header, data.data(), sizeof(header));
+    return header[0] >= PIPELINE_CACHE_HEADER_SIZE &&
+           header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header[2] == props.vendorID && header[3] == props.deviceID &&
+           std::memcmp(data.data() + sizeof(header),
+                       props.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+}
+} // namespace
+
+/**
+ * @brief Path of the pipeline cache file of the current PhysicalDevice, keyed
+ * by its pipeline cache UUID and driver version.
+ * Empty if caches are disabled.
+ */
+std::filesystem::path RenderEngine::getPipelineCacheFilePath() const {
+    if (initConfig.cacheDirectory.empty()) {
+        return {};
+    }
+
+    auto props = physicalDevice.getProperties();
+    std::string uuid;
+    for (const auto byte : props.pipelineCacheUUID) {
+        char hex[3];
+        std::snprintf(hex, sizeof(hex), "%02x", byte);
+        uuid += hex;
+    }
+
+    char fileName[96];
+    std::snprintf(fileName, sizeof(fileName), "pipeline_%04x_%04x_%08x_%s.bin",
+                  props.vendorID, props.deviceID, props.driverVersion,
+                  uuid.c_str());
+    return initConfig.cacheDirectory / fileName;
+}
+
+/**
+ * @brief Create the PipelineCache, with the data saved by the previous run if
+ * it is compatible with the current device.
+ */
+void RenderEngine::createPipelineCache() {
+    std::vector<char> data;
+
+    auto filePath = getPipelineCacheFilePath();
+    if (!filePath.empty()) {
+        std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+        if (file) {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            if (!file.read(data.data(), data.size()) ||
+                !isPipelineCacheCompatible(data,
+                                           physicalDevice.getProperties())) {
+                LOG(INFO) << "Ignoring incompatible pipeline cache: "
+                          << filePath;
+                data.clear();
+            }
+        }
+    }
+
+    vk::PipelineCacheCreateInfo pipelineCacheCI{};
+    pipelineCacheCI.initialDataSize = data.size();
+    pipelineCacheCI.pInitialData = data.data();
+
+    pipelineCache = device.createPipelineCache(pipelineCacheCI);
+    VLOG(VLOG_LV_3_PROCESS_TRACKING)
+        << "PipelineCache has been created with " << data.size()
+        << " bytes of saved data.";
+}
+
+/**
+ * @brief Write the PipelineCache data to the cache directory.
+ * Failures are only logged, the cache is rebuilt at the next run.
+ */
+void RenderEngine::savePipelineCache() {
+    if (!pipelineCache) {
+        return;
+    }
+    auto filePath = getPipelineCacheFilePath();
+    if (filePath.empty()) {
+        return;
+    }
+
+    auto data = device.getPipelineCacheData(pipelineCache);
+
+    std::error_code ec;
+    std::filesystem::create_directories(filePath.parent_path(), ec);
+
+    // written to a temporary file first so that a partial file is never read
+    auto tmpPath = filePath;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(data.data()), data.size());
+        if (!file) {
+            LOG(WARNING) << "Failed to save pipeline cache: " << tmpPath;
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, filePath, ec);
+    if (ec) {
+        LOG(WARNING) << "Failed to save pipeline cache: " << filePath;
+        std::filesystem::remove(tmpPath, ec);
+        return;
+    }
+
+    VLOG(VLOG_LV_3_PROCESS_TRACKING)
+        << "PipelineCache has been saved to " << filePath;
+}
+
+std::filesystem::path RenderEngine::getShaderCacheDirectory() const {
+    if (initConfig.cacheDirectory.empty()) {
+        return {};
+    }
+    return initConfig.cacheDirectory / "spirv";
+}
+} // namespace ikura
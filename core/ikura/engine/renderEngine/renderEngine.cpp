@@ -29,6 +29,11 @@ uint32_t QueueFamilyIndices::get(const QueueIndexKey key) const {
     return indices.at(key).value();
 }
 
+bool QueueFamilyIndices::has(const QueueIndexKey key) const {
+    auto iter = indices.find(key);
+    return iter != indices.end() && iter->second.has_value();
+}
+
 void QueueFamilyIndices::set(QueueIndexKey key, uint32_t value) {
     indices.insert_or_assign(key, value);
 }
@@ -67,6 +72,15 @@ RenderEngine::RenderEngine(RenderEngineInitConfig initConfig) {
 }
 
 RenderEngine::~RenderEngine() {
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Destroying UploadManager...";
+    uploadManager.reset();
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "UploadManager has been destroyed.";
+
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Destroying PipelineCache...";
+    savePipelineCache();
+    device.destroyPipelineCache(pipelineCache);
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "PipelineCache has been destroyed.";
+
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Destroying CommandPool...";
     device.destroyCommandPool(cmdPool);
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "CommandPool has been destroyed.";
@@ -126,6 +140,8 @@ void RenderEngine::endSingleTimeCommands(vk::CommandBuffer cmdBuffer) {
     device.freeCommandBuffers(cmdPool, cmdBuffer);
 }
 
+UploadManager &RenderEngine::getUploadManager() { return *uploadManager; }
+
 const vk::Instance RenderEngine::getInstance() const { return instance; }
 
 const vk::PhysicalDevice RenderEngine::getPhysicalDevice() const {
@@ -148,6 +164,10 @@ const std::shared_ptr<VmaAllocator> RenderEngine::getVmaAllocator() const {
 
 const vk::CommandPool RenderEngine::getCommandPool() const { return cmdPool; }
 
+const vk::PipelineCache RenderEngine::getPipelineCache() const {
+    return pipelineCache;
+}
+
 const RenderEngine::Queues &RenderEngine::getQueues() const { return queues; }
 
 void RenderEngine::setSampleSurface(vk::SurfaceKHR surface) {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -14,6 +15,7 @@
 #include <vk_mem_alloc.h>
 
 #include "../../misc/initVulkanHppDispatchLoader.hpp"
+#include "./uploadManager.hpp"
 
 #define VALIDATION_LAYER_NAME "VK_LAYER_KHRONOS_validation"
 #define IKURA_APP_INFO_ENGINE_NAME "Ikura"
@@ -28,10 +30,17 @@ class RenderTarget;
 struct RenderEngineInfo {
     struct SupportInfo {
         bool isGlfwSupported;
+        // several draws in one indirect draw command
+        bool isMultiDrawIndirectSupported;
+        // indirect draws starting from an instance other than 0
+        bool isDrawIndirectFirstInstanceSupported;
     } support;
 
     struct LimitInfo {
         vk::SampleCountFlagBits maxMsaaSamples;
+        vk::DeviceSize minUniformBufferOffsetAlignment;
+        vk::DeviceSize minStorageBufferOffsetAlignment;
+        uint32_t maxDrawIndirectCount;
     } limit;
 };
 
@@ -42,10 +51,13 @@ class QueueFamilyIndices {
   public:
     static const QueueIndexKey GRAPHICS = 0;
     static const QueueIndexKey PRESENT = 1;
+    // Optional, set only for a family without graphics capability
+    static const QueueIndexKey TRANSFER = 2;
 
     QueueFamilyIndices();
 
     uint32_t get(const QueueIndexKey key) const;
+    bool has(const QueueIndexKey key) const;
     void set(QueueIndexKey key, uint32_t value);
 
     std::set<uint32_t> generateUniqueSet();
@@ -69,6 +81,11 @@ struct RenderEngineInitConfig {
     std::vector<const char *> instanceExtensionNames;
     std::vector<const char *> deviceExtensionNames;
 
+    // Caches ----------
+    // Directory for the pipeline cache and compiled SPIR-V, which should be
+    // writable. Caches are disabled if empty.
+    std::filesystem::path cacheDirectory;
+
     // callbacks ----------
     std::function<vk::PhysicalDevice(const RenderEngine *,
                                      std::vector<vk::PhysicalDevice>)>
@@ -90,9 +107,12 @@ class RenderEngine {
     struct Queues {
         vk::Queue graphicsQueue;
         vk::Queue presentQueue;
+        // same as graphicsQueue without a dedicated transfer family
+        vk::Queue transferQueue;
     } queues;
     QueueFamilyIndices queueFamilyIndices;
     vk::CommandPool cmdPool;
+    vk::PipelineCache pipelineCache;
 
     // Layer / Extension ----------
     std::vector<const char *> layerNames;
@@ -108,11 +128,17 @@ class RenderEngine {
     // Misc ----------
     vk::SurfaceKHR sampleSurface; // for PhysicalDevice suitability evaluation
     std::shared_ptr<VmaAllocator> vmaAllocator;
+    std::unique_ptr<UploadManager> uploadManager;
 
     // Functions ==========
     // Destruction ----------
     void destroyExtensions();
 
+    // Pipeline cache ----------
+    std::filesystem::path getPipelineCacheFilePath() const;
+    void createPipelineCache();
+    void savePipelineCache();
+
     // Misc ----------
     static vk::DebugUtilsMessengerCreateInfoEXT getDebugUtilsMessengerCI();
 
@@ -130,6 +156,7 @@ class RenderEngine {
     // Command ----------
     vk::CommandBuffer beginSingleTimeCommands();
     void endSingleTimeCommands(vk::CommandBuffer commandBuffer);
+    UploadManager &getUploadManager();
 
     // Getter ----------
     const vk::Instance getInstance() const;
@@ -139,6 +166,9 @@ class RenderEngine {
     const QueueFamilyIndices getQueueFamilyIndices() const;
     const std::shared_ptr<VmaAllocator> getVmaAllocator() const;
     const vk::CommandPool getCommandPool() const;
+    const vk::PipelineCache getPipelineCache() const;
+    /// Directory for compiled SPIR-V, empty if caches are disabled.
+    std::filesystem::path getShaderCacheDirectory() const;
     const Queues &getQueues() const;
 
     // Setter ----------
@@ -0,0 +1,408 @@
+#include "./uploadManager.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <easylogging++.h>
+
+#include "../../common/logLevels.hpp"
+
+namespace ikura {
+namespace {
+// Offset alignment of each copy in the staging ring.
+constexpr vk::DeviceSize STAGING_ALIGNMENT = 16;
+
+vk::DeviceSize alignUp(vk::DeviceSize size, vk::DeviceSize alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+UploadManager::UploadManager(vk::Device device, VmaAllocator allocator,
+                             vk::Queue transferQueue,
+                             uint32_t transferQueueFamilyIndex,
+                             vk::Queue graphicsQueue,
+                             uint32_t graphicsQueueFamilyIndex,
+                             vk::DeviceSize capacity) {
+    this->device = device;
+    this->allocator = allocator;
+    this->transferQueue = transferQueue;
+    this->transferQueueFamilyIndex = transferQueueFamilyIndex;
+    this->graphicsQueue = graphicsQueue;
+    this->graphicsQueueFamilyIndex = graphicsQueueFamilyIndex;
+    this->capacity = capacity;
+
+    // Command pools ----------
+    vk::CommandPoolCreateInfo cmdPoolCI{};
+    cmdPoolCI.flags = vk::CommandPoolCreateFlagBits::eTransient;
+    cmdPoolCI.queueFamilyIndex = transferQueueFamilyIndex;
+    transferCmdPool = device.createCommandPool(cmdPoolCI);
+    if (hasDedicatedTransferQueue()) {
+        cmdPoolCI.queueFamilyIndex = graphicsQueueFamilyIndex;
+        acquireCmdPool = device.createCommandPool(cmdPoolCI);
+    }
+
+    // Staging ring ----------
+    vk::BufferCreateInfo bufferCI{};
+    bufferCI.size = capacity;
+    bufferCI.usage = vk::BufferUsageFlagBits::eTransferSrc;
+    bufferCI.sharingMode = vk::SharingMode::eExclusive;
+
+    VmaAllocationCreateInfo allocCI{};
+    allocCI.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+    allocCI.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                    VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    auto vkBufferCI = (VkBufferCreateInfo)bufferCI;
+    VkBuffer vkBuffer;
+    VmaAllocationInfo allocInfo{};
+
+    auto result = vmaCreateBuffer(allocator, &vkBufferCI, &allocCI, &vkBuffer,
+                                  &stagingAlloc, &allocInfo);
+    if (result != VK_SUCCESS) {
+        device.destroyCommandPool(transferCmdPool);
+        device.destroyCommandPool(acquireCmdPool);
+        throw std::runtime_error("Failed to create staging ring buffer.");
+    }
+
+    stagingBuffer = vk::Buffer(vkBuffer);
+    stagingData = static_cast<char *>(allocInfo.pMappedData);
+
+    VLOG(VLOG_LV_3_PROCESS_TRACKING)
+        << "UploadManager with " << capacity
+        << " bytes of staging ring has been created"
+        << (hasDedicatedTransferQueue() ? " on dedicated transfer queue."
+                                        : ".");
+}
+
+UploadManager::~UploadManager() {
+    if (recordingCmdBuffer) {
+        recordingCmdBuffer.end();
+        device.freeCommandBuffers(transferCmdPool, recordingCmdBuffer);
+    }
+    while (!inFlight.empty()) {
+        retireOldest();
+    }
+
+    device.destroyCommandPool(transferCmdPool);
+    device.destroyCommandPool(acquireCmdPool);
+    vmaDestroyBuffer(allocator, (VkBuffer)stagingBuffer, stagingAlloc);
+}
+
+UploadManager::Ticket UploadManager::enqueueCopy(const void *srcData,
+                                                 vk::DeviceSize size,
+                                                 vk::Buffer dstBuffer,
+                                                 vk::DeviceSize dstOffset) {
+    advance();
+
+    // Data larger than the ring is copied in chunks, possibly over several
+    // submissions.
+    auto src = static_cast<const char *>(srcData);
+    copyingDstBuffer = dstBuffer;
+    while (size > 0) {
+        vk::DeviceSize chunkSize = std::min(size, capacity);
+        vk::DeviceSize offset = reserve(chunkSize);
+
+        memcpy(stagingData + offset, src, chunkSize);
+        vmaFlushAllocation(allocator, stagingAlloc, offset, chunkSize);
+
+        beginRecordingIfNeeded();
+        vk::BufferCopy copy{};
+        copy.srcOffset = offset;
+        copy.dstOffset = dstOffset;
+        copy.size = chunkSize;
+        recordingCmdBuffer.copyBuffer(stagingBuffer, dstBuffer, copy);
+        if (std::find(recordingDstBuffers.begin(), recordingDstBuffers.end(),
+                      dstBuffer) == recordingDstBuffers.end()) {
+            recordingDstBuffers.push_back(dstBuffer);
+        }
+
+        src += chunkSize;
+        dstOffset += chunkSize;
+        size -= chunkSize;
+    }
+    copyingDstBuffer = nullptr;
+    return nextTicket;
+}
+
+UploadManager::Ticket UploadManager::submit() {
+    advance();
+    if (!recordingCmdBuffer) {
+        return nextTicket - 1;
+    }
+
+    // A buffer still being copied stays owned by the transfer queue until
+    // its last chunk is submitted.
+    recordingDstBuffers.erase(std::remove(recordingDstBuffers.begin(),
+                                          recordingDstBuffers.end(),
+                                          copyingDstBuffer),
+                              recordingDstBuffers.end());
+
+    if (hasDedicatedTransferQueue()) {
+        // Release the destination buffers to the graphics queue family
+        std::vector<vk::BufferMemoryBarrier> barriers;
+        for (const auto &buffer : recordingDstBuffers) {
+            vk::BufferMemoryBarrier barrier{};
+            barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            barrier.srcQueueFamilyIndex = transferQueueFamilyIndex;
+            barrier.dstQueueFamilyIndex = graphicsQueueFamilyIndex;
+            barrier.buffer = buffer;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            barriers.push_back(barrier);
+        }
+        recordingCmdBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eBottomOfPipe, {}, nullptr, barriers,
+            nullptr);
+    } else {
+        // Make the copied data visible to commands submitted after this.
+        vk::MemoryBarrier barrier{};
+        barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+        barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead |
+                                vk::AccessFlagBits::eIndexRead |
+                                vk::AccessFlagBits::eUniformRead |
+                                vk::AccessFlagBits::eShaderRead;
+        recordingCmdBuffer.pipelineBarrier(
+            vk::PipelineStageFlagBits::eTransfer,
+            vk::PipelineStageFlagBits::eVertexInput |
+                vk::PipelineStageFlagBits::eVertexShader,
+            {}, barrier, nullptr, nullptr);
+    }
+    recordingCmdBuffer.end();
+
+    Submission submission{};
+    submission.ticket = nextTicket++;
+    submission.transferCmdBuffer = recordingCmdBuffer;
+    submission.transferFence = device.createFence(vk::FenceCreateInfo{});
+    submission.dstBuffers = std::move(recordingDstBuffers);
+    submission.ringEnd = head;
+
+    vk::SubmitInfo submitInfo{};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &submission.transferCmdBuffer;
+    if (hasDedicatedTransferQueue()) {
+        submission.transferredSemaphore =
+            device.createSemaphore(vk::SemaphoreCreateInfo{});
+        submitInfo.setSignalSemaphores(submission.transferredSemaphore);
+    }
+    transferQueue.submit(submitInfo, submission.transferFence);
+
+    inFlight.push_back(std::move(submission));
+    recordingCmdBuffer = nullptr;
+    recordingDstBuffers.clear();
+
+    VLOG(VLOG_LV_4_PROCESS_TRACKING_SECONDARY)
+        << "Upload submission " << inFlight.back().ticket
+        << " has been submitted.";
+    return inFlight.back().ticket;
+}
+
+void UploadManager::wait(Ticket ticket) {
+    if (ticket >= nextTicket) {
+        submit();
+    }
+    while (completedTicket < ticket && !inFlight.empty()) {
+        retireOldest();
+    }
+}
+
+void UploadManager::flush() { wait(submit()); }
+
+bool UploadManager::isCompleted(Ticket ticket) {
+    advance();
+    return ticket <= completedTicket;
+}
+
+bool UploadManager::hasDedicatedTransferQueue() const {
+    return transferQueueFamilyIndex != graphicsQueueFamilyIndex;
+}
+
+/**
+ * @brief Reserve `size` bytes of the ring without waiting.
+ * The ring never becomes completely full so that head == tail always means
+ * it is empty.
+ *
+ * @return false if the ring has no contiguous room for `size` bytes.
+ */
+bool UploadManager::tryReserve(vk::DeviceSize size, vk::DeviceSize &offset) {
+    if (inFlight.empty() && !recordingCmdBuffer) {
+        head = 0;
+        tail = 0;
+    }
+
+    vk::DeviceSize alignedHead = alignUp(head, STAGING_ALIGNMENT);
+    if (head >= tail) {
+        if (alignedHead + size <= capacity) {
+            offset = alignedHead;
+        } else if (size < tail) {
+            // wrap around, the rest of the ring is left unused
+            offset = 0;
+        } else {
+            return false;
+        }
+    } else if (alignedHead + size < tail) {
+        offset = alignedHead;
+    } else {
+        return false;
+    }
+
+    head = offset + size;
+    return true;
+}
+
+/**
+ * @brief Reserve `size` bytes of the ring, waiting for the oldest
+ * submissions to complete until there is room.
+ */
+vk::DeviceSize UploadManager::reserve(vk::DeviceSize size) {
+    vk::DeviceSize offset;
+    while (!tryReserve(size, offset)) {
+        // Copies still being recorded hold ring space too.
+        if (recordingCmdBuffer) {
+            submit();
+        }
+        retireOldest();
+    }
+    return offset;
+}
+
+void UploadManager::beginRecordingIfNeeded() {
+    if (recordingCmdBuffer) {
+        return;
+    }
+
+    vk::CommandBufferAllocateInfo allocInfo{};
+    allocInfo.level = vk::CommandBufferLevel::ePrimary;
+    allocInfo.commandPool = transferCmdPool;
+    allocInfo.commandBufferCount = 1;
+
+    auto result =
+        device.allocateCommandBuffers(&allocInfo, &recordingCmdBuffer);
+    if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("Failed to allocate upload CommandBuffer.");
+    }
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    result = recordingCmdBuffer.begin(&beginInfo);
+    if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("Failed to begin upload CommandBuffer.");
+    }
+}
+
+/**
+ * @brief Submit the acquisition of the buffers transferred by `submission` to
+ * the graphics queue.
+ */
+void UploadManager::acquireOwnership(Submission &submission) {
+    vk::CommandBufferAllocateInfo allocInfo{};
+    allocInfo.level = vk::CommandBufferLevel::ePrimary;
+    allocInfo.commandPool = acquireCmdPool;
+    allocInfo.commandBufferCount = 1;
+
+    auto result = device.allocateCommandBuffers(&allocInfo,
+                                                &submission.acquireCmdBuffer);
+    if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("Failed to allocate acquire CommandBuffer.");
+    }
+
+    vk::CommandBufferBeginInfo beginInfo{};
+    beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    result = submission.acquireCmdBuffer.begin(&beginInfo);
+    if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("Failed to begin acquire CommandBuffer.");
+    }
+
+    std::vector<vk::BufferMemoryBarrier> barriers;
+    for (const auto &buffer : submission.dstBuffers) {
+        vk::BufferMemoryBarrier barrier{};
+        barrier.dstAccessMask = vk::AccessFlagBits::eVertexAttributeRead |
+                                vk::AccessFlagBits::eIndexRead |
+                                vk::AccessFlagBits::eUniformRead |
+                                vk::AccessFlagBits::eShaderRead;
+        barrier.srcQueueFamilyIndex = transferQueueFamilyIndex;
+        barrier.dstQueueFamilyIndex = graphicsQueueFamilyIndex;
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        barriers.push_back(barrier);
+    }
+    const vk::PipelineStageFlags dstStages =
+        vk::PipelineStageFlagBits::eVertexInput |
+        vk::PipelineStageFlagBits::eVertexShader;
+    submission.acquireCmdBuffer.pipelineBarrier(
+        vk::PipelineStageFlagBits::eTopOfPipe, dstStages, {}, nullptr,
+        barriers, nullptr);
+    submission.acquireCmdBuffer.end();
+
+    submission.acquireFence = device.createFence(vk::FenceCreateInfo{});
+
+    vk::SubmitInfo submitInfo{};
+    submitInfo.setWaitSemaphores(submission.transferredSemaphore);
+    submitInfo.setWaitDstStageMask(dstStages);
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &submission.acquireCmdBuffer;
+    graphicsQueue.submit(submitInfo, submission.acquireFence);
+}
+
+bool UploadManager::isFinished(const Submission &submission) const {
+    if (hasDedicatedTransferQueue()) {
+        return submission.acquireFence &&
+               device.getFenceStatus(submission.acquireFence) ==
+                   vk::Result::eSuccess;
+    }
+    return device.getFenceStatus(submission.transferFence) ==
+           vk::Result::eSuccess;
+}
+
+/**
+ * @brief Hand finished transfers over to the graphics queue and retire
+ * completed submissions, without blocking.
+ */
+void UploadManager::advance() {
+    if (hasDedicatedTransferQueue()) {
+        for (auto &submission : inFlight) {
+            if (!submission.acquireFence &&
+                device.getFenceStatus(submission.transferFence) ==
+                    vk::Result::eSuccess) {
+                acquireOwnership(submission);
+            }
+        }
+    }
+
+    while (!inFlight.empty() && isFinished(inFlight.front())) {
+        retireOldest();
+    }
+}
+
+void UploadManager::retireOldest() {
+    Submission &oldest = inFlight.front();
+    auto result =
+        device.waitForFences(oldest.transferFence, VK_TRUE, UINT64_MAX);
+    if (result != vk::Result::eSuccess) {
+        throw std::runtime_error("Error occurred while waiting upload fence.");
+    }
+
+    if (hasDedicatedTransferQueue()) {
+        if (!oldest.acquireFence) {
+            acquireOwnership(oldest);
+        }
+        result = device.waitForFences(oldest.acquireFence, VK_TRUE, UINT64_MAX);
+        if (result != vk::Result::eSuccess) {
+            throw std::runtime_error(
+                "Error occurred while waiting upload fence.");
+        }
+
+        device.destroyFence(oldest.acquireFence);
+        device.destroySemaphore(oldest.transferredSemaphore);
+        device.freeCommandBuffers(acquireCmdPool, oldest.acquireCmdBuffer);
+    }
+
+    tail = oldest.ringEnd;
+    completedTicket = oldest.ticket;
+    device.destroyFence(oldest.transferFence);
+    device.freeCommandBuffers(transferCmdPool, oldest.transferCmdBuffer);
+    inFlight.pop_front();
+}
+} // namespace ikura
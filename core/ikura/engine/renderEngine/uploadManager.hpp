@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include <vk_mem_alloc.h>
+
+namespace ikura {
+/**
+ * @brief Uploads host data to device-local buffers through a persistent
+ * staging ring buffer.
+ *
+ * Copies are recorded into one pending command buffer and sent to the queue
+ * by a single submit(). Each submission owns a region of the ring until its
+ * fence is signaled; the queue itself is never waited idle.
+ *
+ * With a dedicated transfer queue, copies run there concurrently with
+ * rendering. The destination buffers are then released to the graphics queue
+ * family and acquired by a small graphics submission waiting on a semaphore,
+ * which is issued once the transfer has finished so that frames submitted in
+ * the meantime are not held back.
+ */
+class UploadManager {
+  public:
+    /// Identifies a submission. Tickets increase monotonically.
+    typedef uint64_t Ticket;
+
+    static constexpr vk::DeviceSize DEFAULT_STAGING_CAPACITY = 16u << 20;
+
+  private:
+    struct Submission {
+        Ticket ticket;
+        vk::CommandBuffer transferCmdBuffer;
+        vk::Fence transferFence;
+        // Ownership acquisition on the graphics queue, dedicated transfer
+        // queue only
+        vk::Semaphore transferredSemaphore;
+        vk::CommandBuffer acquireCmdBuffer;
+        vk::Fence acquireFence;
+        std::vector<vk::Buffer> dstBuffers;
+        // ring position just after the last byte used by this submission
+        vk::DeviceSize ringEnd;
+    };
+
+    // Variables ==========
+    vk::Device device;
+    VmaAllocator allocator;
+    vk::Queue transferQueue;
+    vk::Queue graphicsQueue;
+    uint32_t transferQueueFamilyIndex;
+    uint32_t graphicsQueueFamilyIndex;
+    vk::CommandPool transferCmdPool;
+    vk::CommandPool acquireCmdPool;
+
+    // Staging ring ----------
+    vk::Buffer stagingBuffer;
+    VmaAllocation stagingAlloc;
+    char *stagingData = nullptr;
+    vk::DeviceSize capacity;
+    // bytes in [tail, head) (wrapping around) are owned by submissions
+    vk::DeviceSize head = 0;
+    vk::DeviceSize tail = 0;
+
+    // Submissions ----------
+    vk::CommandBuffer recordingCmdBuffer;
+    std::vector<vk::Buffer> recordingDstBuffers;
+    // destination of the copy enqueueCopy() is splitting into chunks
+    vk::Buffer copyingDstBuffer;
+    std::deque<Submission> inFlight;
+    Ticket nextTicket = 1;
+    Ticket completedTicket = 0;
+
+    // Functions ==========
+    bool tryReserve(vk::DeviceSize size, vk::DeviceSize &offset);
+    vk::DeviceSize reserve(vk::DeviceSize size);
+    void beginRecordingIfNeeded();
+    void acquireOwnership(Submission &submission);
+    bool isFinished(const Submission &submission) const;
+    void advance();
+    void retireOldest();
+
+  public:
+    /// Pass the graphics queue as `transferQueue` too if the device has no
+    /// dedicated transfer queue.
+    UploadManager(vk::Device device, VmaAllocator allocator,
+                  vk::Queue transferQueue, uint32_t transferQueueFamilyIndex,
+                  vk::Queue graphicsQueue, uint32_t graphicsQueueFamilyIndex,
+                  vk::DeviceSize capacity = DEFAULT_STAGING_CAPACITY);
+    ~UploadManager();
+
+    UploadManager(const UploadManager &) = delete;
+    UploadManager &operator=(const UploadManager &) = delete;
+
+    /// Record a copy of `size` bytes from `srcData` to `dstBuffer` at
+    /// `dstOffset`. `srcData` can be released as soon as this returns.
+    /// Returns the ticket of the submission the copy will complete with.
+    Ticket enqueueCopy(const void *srcData, vk::DeviceSize size,
+                       vk::Buffer dstBuffer, vk::DeviceSize dstOffset = 0);
+    /// Submit all recorded copies at once and move earlier submissions
+    /// forward without blocking. Commands submitted to the graphics queue
+    /// after a ticket has completed see its data. Returns the ticket of the
+    /// submission, or the latest one if nothing was recorded.
+    Ticket submit();
+    /// Block until the submission `ticket` has completed on the device,
+    /// submitting it first if it is still being recorded.
+    void wait(Ticket ticket);
+    /// Submit recorded copies and block until all of them have completed.
+    void flush();
+
+    bool isCompleted(Ticket ticket);
+    bool hasDedicatedTransferQueue() const;
+};
+} // namespace ikura
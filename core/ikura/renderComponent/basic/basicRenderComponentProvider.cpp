@@ -9,19 +9,15 @@
 namespace ikura {
 void BasicRenderComponentProvider::createDescriptorSetlayout() {
     vk::DescriptorSetLayoutBinding modelMatLayoutBinding{};
-    modelMatLayoutBinding.binding = DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO;
+    modelMatLayoutBinding.binding = DESCRIPTOR_SET_BINDING_MODEL_MATRIX_SSBO;
     modelMatLayoutBinding.descriptorCount = 1;
-    modelMatLayoutBinding.descriptorType = vk::DescriptorType::eUniformBuffer;
+    modelMatLayoutBinding.descriptorType =
+        vk::DescriptorType::eStorageBufferDynamic;
     modelMatLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex;
 
-    vk::DescriptorSetLayoutBinding sceneMatLayoutBinding{};
-    sceneMatLayoutBinding.binding = DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO;
-    sceneMatLayoutBinding.descriptorCount = 1;
-    sceneMatLayoutBinding.descriptorType = vk::DescriptorType::eUniformBuffer;
-    sceneMatLayoutBinding.stageFlags = vk::ShaderStageFlagBits::eVertex;
-
+    // scene matrices are push constants
     std::array<vk::DescriptorSetLayoutBinding, NUM_OF_DESCRIPTORS>
-        layoutBindings = {modelMatLayoutBinding, sceneMatLayoutBinding};
+        layoutBindings = {modelMatLayoutBinding};
     vk::DescriptorSetLayoutCreateInfo layoutCI{};
     layoutCI.bindingCount = layoutBindings.size();
     layoutCI.pBindings = layoutBindings.data();
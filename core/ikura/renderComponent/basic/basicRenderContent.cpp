@@ -1,5 +1,10 @@
 #include "./basicRenderContent.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
 #include <easylogging++.h>
 
 #include "../../shape/shapes.hpp"
@@ -11,158 +16,186 @@
 // for demo
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/gtc/matrix_access.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 namespace ikura {
-void BasicRenderContent::setupUniformBuffers() {
-    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Creating default UniformBuffers...";
+// Model matrices each frame can hold before the first growth
+const size_t INITIAL_MODEL_MATRIX_CAPACITY = 256;
+// Indirect draw commands each frame can hold before the first growth
+const size_t INITIAL_INDIRECT_COMMAND_CAPACITY = 256;
+
+namespace {
+/**
+ * @brief Planes of the view frustum of `viewProj`, pointing inside and
+ * normalized, with the depth range of [0, 1].
+ */
+std::array<glm::vec4, 6> extractFrustumPlanes(const glm::mat4 &viewProj) {
+    const glm::vec4 row0 = glm::row(viewProj, 0);
+    const glm::vec4 row1 = glm::row(viewProj, 1);
+    const glm::vec4 row2 = glm::row(viewProj, 2);
+    const glm::vec4 row3 = glm::row(viewProj, 3);
+
+    std::array<glm::vec4, 6> planes = {
+        row3 + row0, // left
+        row3 - row0, // right
+        row3 + row1, // bottom
+        row3 - row1, // top
+        row2,        // near
+        row3 - row2, // far
+    };
+    for (auto &plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
 
-    std::array<vk::DeviceSize, NUM_OF_DESCRIPTORS> uniformBufferSizes;
-    uniformBufferSizes[DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO] =
-        sizeof(BasicModelMatUBO);
-    uniformBufferSizes[DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO] =
-        sizeof(BasicSceneMatUBO);
+/// Whether the sphere is at least partially inside all of `planes`.
+bool isSphereInFrustum(const std::array<glm::vec4, 6> &planes,
+                       const glm::vec3 &center, float radius) {
+    for (const auto &plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+/**
+ * @brief (Re)create the arena holding indirect draw commands of all frames.
+ *
+ * Commands of every frame are dropped, so no frame may be using the arena
+ * and all of them must be culled again.
+ */
+void BasicRenderContent::setupIndirectCommandArena(size_t capacity) {
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Creating indirect command arena...";
+
+    const vk::DeviceSize sliceSize =
+        sizeof(vk::DrawIndexedIndirectCommand) * capacity;
+    // offsets of indirect commands must be a multiple of 4
+    const vk::DeviceSize alignment = sizeof(uint32_t);
+
+    indirectCommandArena.reset();
+    indirectCommandArena = std::make_unique<UniformArena>(
+        renderEngine,
+        UniformArena::alignSize(sliceSize, alignment) * numOfFrames,
+        vk::BufferUsageFlagBits::eIndirectBuffer, alignment);
+
+    indirectCommandSlices.resize(numOfFrames);
+    for (size_t frame = 0; frame < numOfFrames; frame++) {
+        indirectCommandSlices[frame] =
+            indirectCommandArena->allocate(sliceSize);
+    }
+    indirectCommandCapacity = capacity;
+    culledCommands.resize(numOfFrames);
+    for (auto &commands : culledCommands) {
+        commands.clear();
+    }
 
-    uniformBufferResources.resize(numOfFrames);
+    VLOG(VLOG_LV_3_PROCESS_TRACKING)
+        << "Indirect command arena has been created.";
+}
 
+/**
+ * @brief (Re)create the arena holding model matrices of all frames.
+ *
+ * Each frame in flight gets a slice for `capacity` matrices. The existing
+ * arena is released, so no frame may be using it.
+ */
+void BasicRenderContent::setupModelMatrixArena(size_t capacity) {
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Creating model matrix arena...";
+
+    const vk::DeviceSize sliceSize = sizeof(glm::mat4) * capacity;
+    const vk::DeviceSize alignment =
+        renderEngine->getEngineInfo().limit.minStorageBufferOffsetAlignment;
+
+    modelMatrixArena.reset();
+    modelMatrixArena = std::make_unique<UniformArena>(
+        renderEngine,
+        UniformArena::alignSize(sliceSize, alignment) * numOfFrames,
+        vk::BufferUsageFlagBits::eStorageBuffer, alignment);
+
+    modelMatrixSlices.resize(numOfFrames);
     for (size_t frame = 0; frame < numOfFrames; frame++) {
-        uniformBufferResources[frame].resize(NUM_OF_DESCRIPTORS);
-
-        for (size_t descSetIndex = 0; descSetIndex < NUM_OF_DESCRIPTORS;
-             descSetIndex++) {
-            // TODO: create large DeviceMemory and assign part of them to each
-            // uniformBuffers
-            vk::BufferCreateInfo bufferCI{};
-            bufferCI.size = uniformBufferSizes[descSetIndex];
-            bufferCI.usage = vk::BufferUsageFlagBits::eUniformBuffer;
-            bufferCI.sharingMode = vk::SharingMode::eExclusive;
-
-            VmaAllocationCreateInfo allocCI{};
-            allocCI.usage = VMA_MEMORY_USAGE_AUTO;
-            allocCI.flags =
-                VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                VMA_ALLOCATION_CREATE_MAPPED_BIT;
-
-            auto vkBufferCI = (VkBufferCreateInfo)bufferCI;
-            VkBuffer vkBuffer;
-
-            vmaCreateBuffer(*renderEngine->getVmaAllocator(), &vkBufferCI,
-                            &allocCI, &vkBuffer,
-                            &uniformBufferResources[frame][descSetIndex].alloc,
-                            nullptr);
-
-            vk::Buffer buffer(vkBuffer);
-            uniformBufferResources[frame][descSetIndex].buffer = buffer;
-        }
+        modelMatrixSlices[frame] = modelMatrixArena->allocate(sliceSize);
     }
+    modelMatrixCapacity = capacity;
 
-    VLOG(VLOG_LV_3_PROCESS_TRACKING)
-        << "Default UniformBuffers has been created.";
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Model matrix arena has been created.";
 }
 
 void BasicRenderContent::setupDescriptorSets() {
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Creating default DescriptorSets...";
 
     // DescriptorPool ----------
-    std::array<vk::DescriptorPoolSize, 2> poolSizes;
-    poolSizes[DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO].type =
-        vk::DescriptorType::eUniformBuffer;
-    poolSizes[DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO].descriptorCount =
-        static_cast<uint32_t>(numOfFrames * NUM_OF_DESCRIPTORS);
-    poolSizes[DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO].type =
-        vk::DescriptorType::eUniformBuffer;
-    poolSizes[DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO].descriptorCount =
-        static_cast<uint32_t>(numOfFrames);
+    std::array<vk::DescriptorPoolSize, NUM_OF_DESCRIPTORS> poolSizes;
+    poolSizes[DESCRIPTOR_SET_BINDING_MODEL_MATRIX_SSBO].type =
+        vk::DescriptorType::eStorageBufferDynamic;
+    poolSizes[DESCRIPTOR_SET_BINDING_MODEL_MATRIX_SSBO].descriptorCount = 1;
 
     vk::DescriptorPoolCreateInfo poolCI{};
     poolCI.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolCI.pPoolSizes = poolSizes.data();
-    poolCI.maxSets =
-        static_cast<uint32_t>(numOfFrames * NUM_OF_DESCRIPTOR_SETS);
+    poolCI.maxSets = static_cast<uint32_t>(NUM_OF_DESCRIPTOR_SETS);
 
     descriptorPool = renderEngine->getDevice().createDescriptorPool(poolCI);
 
-    // DescriptorSets ==========
-    // Array preparation ----------
-    size_t numOfDescriptorWrites = numOfFrames * NUM_OF_DESCRIPTORS;
-
-    std::vector<vk::WriteDescriptorSet> descriptorWrites;
-    descriptorWrites.resize(numOfDescriptorWrites);
-    std::vector<vk::DescriptorBufferInfo> bufferInfos;
-    bufferInfos.resize(numOfDescriptorWrites);
-
-    descriptorSets.resize(numOfFrames);
+    // DescriptorSets ----------
+    // shared by all frames, which select their slice by dynamic offsets
+    vk::DescriptorSetAllocateInfo allocInfo{};
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = NUM_OF_DESCRIPTOR_SETS;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
 
-    // DescriptorSet Allocation loop per frame ----------
-    size_t index = 0;
-    for (size_t frame = 0; frame < numOfFrames; frame++) {
-        // Allocation ----------
-        vk::DescriptorSetAllocateInfo allocInfo{};
-        allocInfo.descriptorPool = descriptorPool;
-        allocInfo.descriptorSetCount = NUM_OF_DESCRIPTOR_SETS;
-        allocInfo.pSetLayouts = &descriptorSetLayout;
-
-        descriptorSets[frame] =
-            renderEngine->getDevice().allocateDescriptorSets(allocInfo);
-
-        // Fill Update Info ----------
-        // Model Matrix UBO
-        bufferInfos[index].buffer =
-            uniformBufferResources[frame]
-                                  [DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO]
-                                      .buffer;
-        bufferInfos[index].offset = 0;
-        bufferInfos[index].range = VK_WHOLE_SIZE;
-
-        descriptorWrites[index].dstSet =
-            descriptorSets[frame][DESCRIPTOR_SET_INDEX_MODEL_MATRIX_UBO];
-        descriptorWrites[index].dstBinding =
-            DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO;
-        descriptorWrites[index].dstArrayElement = 0;
-        descriptorWrites[index].descriptorType =
-            vk::DescriptorType::eUniformBuffer;
-        descriptorWrites[index].descriptorCount = 1;
-        descriptorWrites[index].pBufferInfo = &bufferInfos[index];
-        index++;
-
-        // Scene Matrix UBO
-        bufferInfos[index].buffer =
-            uniformBufferResources[frame]
-                                  [DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO]
-                                      .buffer;
-        bufferInfos[index].offset = 0;
-        bufferInfos[index].range = VK_WHOLE_SIZE;
-
-        descriptorWrites[index].dstSet =
-            descriptorSets[frame][DESCRIPTOR_SET_INDEX_SCENE_MATRIX_UBO];
-        descriptorWrites[index].dstBinding =
-            DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO;
-        descriptorWrites[index].dstArrayElement = 0;
-        descriptorWrites[index].descriptorType =
-            vk::DescriptorType::eUniformBuffer;
-        descriptorWrites[index].descriptorCount = 1;
-        descriptorWrites[index].pBufferInfo = &bufferInfos[index];
-        index++;
-    }
+    descriptorSets.resize(1);
+    descriptorSets[0] =
+        renderEngine->getDevice().allocateDescriptorSets(allocInfo);
 
-    // Update ----------
-    renderEngine->getDevice().updateDescriptorSets(
-        index, descriptorWrites.data(), 0, nullptr);
+    updateModelMatrixDescriptorSet();
 
     VLOG(VLOG_LV_3_PROCESS_TRACKING)
         << "Default DescriptorSets has been created.";
 }
 
+/// Point the model matrix binding to the current arena.
+void BasicRenderContent::updateModelMatrixDescriptorSet() {
+    vk::DescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = modelMatrixArena->getBuffer();
+    bufferInfo.offset = 0;
+    bufferInfo.range = modelMatrixSlices[0].size;
+
+    vk::WriteDescriptorSet descriptorWrite{};
+    descriptorWrite.dstSet =
+        descriptorSets[0][DESCRIPTOR_SET_INDEX_MODEL_MATRIX_SSBO];
+    descriptorWrite.dstBinding = DESCRIPTOR_SET_BINDING_MODEL_MATRIX_SSBO;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = vk::DescriptorType::eStorageBufferDynamic;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo = &bufferInfo;
+
+    renderEngine->getDevice().updateDescriptorSets(1, &descriptorWrite, 0,
+                                                   nullptr);
+}
+
 BasicRenderContent::BasicRenderContent(
     std::shared_ptr<RenderEngine> renderEngine,
     vk::DescriptorSetLayout descriptorSetLayout, int numOfFrames)
 
     : RenderContent(renderEngine, descriptorSetLayout, numOfFrames) {
 
-    setupUniformBuffers();
+    setupModelMatrixArena(INITIAL_MODEL_MATRIX_CAPACITY);
+    setupIndirectCommandArena(INITIAL_INDIRECT_COMMAND_CAPACITY);
     setupDescriptorSets();
 }
 
+BasicRenderContent::~BasicRenderContent() {
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Destroying InstanceBuffer...";
+    instanceBufferResource.release(*renderEngine->getVmaAllocator());
+    releaseStagedBuffer(stagedInstanceBufferResource);
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "InstanceBuffer has been destroyed.";
+}
+
 void BasicRenderContent::addVertices(const std::vector<BasicVertex> &vertices) {
     this->vertices.insert(this->vertices.end(), vertices.begin(),
                           vertices.end());
@@ -180,35 +213,282 @@ void BasicRenderContent::setIndices(const std::vector<BasicIndex> &indices) {
     this->indices = indices;
 }
 
-void BasicRenderContent::updateUniformBuffer(int frameIndex,
-                                             BasicModelMatUBO &modelMatUBO,
-                                             BasicSceneMatUBO &sceneMatUBO) {
-    void *data;
+BasicRenderContent::Mesh
+BasicRenderContent::addMesh(const std::vector<BasicVertex> &vertices,
+                            const std::vector<BasicIndex> &indices) {
+    Mesh mesh;
+    mesh.firstIndex = static_cast<uint32_t>(this->indices.size());
+    mesh.numOfIndex = static_cast<uint32_t>(indices.size());
+    mesh.vertexOffset = static_cast<int32_t>(this->vertices.size());
+
+    // Bounding sphere ----------
+    // centered on the bounding box, only for meshes drawn entirely with the
+    // model matrix of the instance
+    if (!vertices.empty() &&
+        std::all_of(vertices.begin(), vertices.end(),
+                    [](const BasicVertex &vertex) {
+                        return vertex.data.id == 0;
+                    })) {
+        glm::vec3 minPos = vertices[0].getPos();
+        glm::vec3 maxPos = minPos;
+        for (const auto &vertex : vertices) {
+            minPos = glm::min(minPos, vertex.getPos());
+            maxPos = glm::max(maxPos, vertex.getPos());
+        }
+        mesh.boundingCenter = (minPos + maxPos) * 0.5f;
+        mesh.boundingRadius = 0.0f;
+        for (const auto &vertex : vertices) {
+            mesh.boundingRadius =
+                std::max(mesh.boundingRadius,
+                         glm::length(vertex.getPos() - mesh.boundingCenter));
+        }
+    }
+
+    addVertices(vertices);
+    addIndices(indices);
+
+    return mesh;
+}
+
+void BasicRenderContent::addInstances(
+    const Mesh &mesh, const std::vector<BasicInstance> &instances) {
+    if (instances.empty()) {
+        return;
+    }
+
+    InstancedDraw draw;
+    draw.mesh = mesh;
+    draw.firstInstance = static_cast<uint32_t>(this->instances.size());
+    draw.numOfInstances = static_cast<uint32_t>(instances.size());
+    pendingDraws.push_back(draw);
+
+    this->instances.insert(this->instances.end(), instances.begin(),
+                           instances.end());
+}
+
+void BasicRenderContent::clearInstances() {
+    instances.clear();
+    pendingDraws.clear();
+}
+
+void BasicRenderContent::setGroupVisible(GroupID id, bool visible) {
+    if (id >= hiddenGroups.size()) {
+        if (visible) {
+            return;
+        }
+        hiddenGroups.resize(id + 1, false);
+    }
+    hiddenGroups[id] = !visible;
+}
+
+bool BasicRenderContent::isGroupVisible(GroupID id) const {
+    return id >= hiddenGroups.size() || !hiddenGroups[id];
+}
+
+/**
+ * @brief Write the indirect draw commands of the instances to draw in frame
+ * `frameIndex`.
+ *
+ * Each run of consecutive surviving instances of a draw becomes one command.
+ * The command slices grow to hold one command per instance, waiting for the
+ * device to be idle.
+ */
+void BasicRenderContent::cullInstances(int frameIndex,
+                                       const glm::mat4 *modelMatrices) {
+    // grow the slices of all frames, which must not be in use
+    if (drawnInstances.size() > indirectCommandCapacity) {
+        VLOG(VLOG_LV_3_PROCESS_TRACKING)
+            << "Growing indirect command arena...";
+        renderEngine->waitForDeviceIdle();
+        setupIndirectCommandArena(
+            std::max(drawnInstances.size(), indirectCommandCapacity * 2));
+    }
+
+    const std::array<glm::vec4, 6> planes =
+        extractFrustumPlanes(sceneMat.proj * sceneMat.view);
+
+    std::vector<vk::DrawIndexedIndirectCommand> &commands =
+        culledCommands[frameIndex];
+    commands.clear();
+
+    CullingStatistics statistics;
+    statistics.numOfInstances = static_cast<uint32_t>(drawnInstances.size());
+
+    for (const auto &draw : draws) {
+        vk::DrawIndexedIndirectCommand command{};
+        command.indexCount = draw.mesh.numOfIndex;
+        command.firstIndex = draw.mesh.firstIndex;
+        command.vertexOffset = draw.mesh.vertexOffset;
+
+        const uint32_t end = draw.firstInstance + draw.numOfInstances;
+        for (uint32_t i = draw.firstInstance; i < end; i++) {
+            const BasicInstance::Data &instance = drawnInstances[i].data;
+
+            bool survived = true;
+            if (!isGroupVisible(instance.id)) {
+                statistics.numOfHiddenInstances++;
+                survived = false;
+            } else if (frustumCullingEnabled &&
+                       draw.mesh.boundingRadius >= 0.0f) {
+                const glm::mat4 &modelMatrix = modelMatrices[instance.id];
+                const glm::vec3 center =
+                    glm::vec3(instance.offsetScale) +
+                    instance.offsetScale.w * draw.mesh.boundingCenter;
+                const float maxAxisScale = std::sqrt(
+                    std::max({glm::dot(modelMatrix[0], modelMatrix[0]),
+                              glm::dot(modelMatrix[1], modelMatrix[1]),
+                              glm::dot(modelMatrix[2], modelMatrix[2])}));
+
+                if (!isSphereInFrustum(
+                        planes, glm::vec3(modelMatrix * glm::vec4(center, 1.0)),
+                        instance.offsetScale.w * draw.mesh.boundingRadius *
+                            maxAxisScale)) {
+                    statistics.numOfCulledInstances++;
+                    survived = false;
+                }
+            }
+
+            if (survived) {
+                if (command.instanceCount == 0) {
+                    command.firstInstance = i;
+                }
+                command.instanceCount++;
+            }
+            // close the run
+            if ((!survived || i + 1 == end) && command.instanceCount > 0) {
+                commands.push_back(command);
+                command.instanceCount = 0;
+            }
+        }
+    }
+
+    // the mapped memory is only written, sequentially
+    std::copy(commands.begin(), commands.end(),
+              static_cast<vk::DrawIndexedIndirectCommand *>(
+                  indirectCommandSlices[frameIndex].mappedData));
+    indirectCommandArena->flush(indirectCommandSlices[frameIndex],
+                                sizeof(vk::DrawIndexedIndirectCommand) *
+                                    commands.size());
+
+    statistics.numOfDrawCommands = static_cast<uint32_t>(commands.size());
+    cullingStatistics = statistics;
+}
+
+void BasicRenderContent::setFrustumCullingEnabled(bool enabled) {
+    frustumCullingEnabled = enabled;
+}
+
+const BasicRenderContent::CullingStatistics &
+BasicRenderContent::getCullingStatistics() const {
+    return cullingStatistics;
+}
+
+/**
+ * @brief Return the model matrices of `frameIndex` in the mapped arena, to be
+ * written directly.
+ *
+ * The arena grows to hold `numOfModelMatrices` matrices per frame, waiting
+ * for the device to be idle. Call flushModelMatrices() after writing.
+ */
+glm::mat4 *BasicRenderContent::getMappedModelMatrices(
+    int frameIndex, size_t numOfModelMatrices) {
+    assert(numOfModelMatrices <= MAX_NUM_OF_MODEL_MATRIX);
+
+    // grow the slices of all frames, which must not be in use
+    if (numOfModelMatrices > modelMatrixCapacity) {
+        VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Growing model matrix arena...";
+        renderEngine->waitForDeviceIdle();
+        setupModelMatrixArena(
+            std::max(numOfModelMatrices, modelMatrixCapacity * 2));
+        updateModelMatrixDescriptorSet();
+    }
+
+    return static_cast<glm::mat4 *>(modelMatrixSlices[frameIndex].mappedData);
+}
+
+/// Make the first `numOfModelMatrices` matrices written to the mapped arena
+/// visible to the device. Nothing is done for host-coherent memory.
+void BasicRenderContent::flushModelMatrices(int frameIndex,
+                                            size_t numOfModelMatrices) {
+    modelMatrixArena->flush(modelMatrixSlices[frameIndex],
+                            sizeof(glm::mat4) * numOfModelMatrices);
+}
+
+void BasicRenderContent::setSceneMatrix(
+    const BasicSceneMatPushConstant &sceneMat) {
+    this->sceneMat = sceneMat;
+}
+
+void BasicRenderContent::updateUniformBuffer(
+    int frameIndex, const BasicModelMatSSBO &modelMatSSBO,
+    const BasicSceneMatPushConstant &sceneMat) {
     // Model Matrix
-    vmaMapMemory(*renderEngine->getVmaAllocator(),
-                 uniformBufferResources[frameIndex]
-                                       [DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO]
-                                           .alloc,
-                 &data);
-    memcpy(data, &modelMatUBO, sizeof(modelMatUBO));
-    vmaUnmapMemory(
-        *renderEngine->getVmaAllocator(),
-        uniformBufferResources[frameIndex]
-                              [DESCRIPTOR_SET_BINDING_MODEL_MATRIX_UBO]
-                                  .alloc);
+    // only the matrices in use
+    glm::mat4 *modelMatrices =
+        getMappedModelMatrices(frameIndex, modelMatSSBO.model.size());
+    std::copy(modelMatSSBO.model.begin(), modelMatSSBO.model.end(),
+              modelMatrices);
+    flushModelMatrices(frameIndex, modelMatSSBO.model.size());
 
     // Scene Matrix
-    vmaMapMemory(*renderEngine->getVmaAllocator(),
-                 uniformBufferResources[frameIndex]
-                                       [DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO]
-                                           .alloc,
-                 &data);
-    memcpy(data, &sceneMatUBO, sizeof(sceneMatUBO));
-    vmaUnmapMemory(
-        *renderEngine->getVmaAllocator(),
-        uniformBufferResources[frameIndex]
-                              [DESCRIPTOR_SET_BINDING_SCENE_MATRIX_UBO]
-                                  .alloc);
+    setSceneMatrix(sceneMat);
+
+    cullInstances(frameIndex, modelMatSSBO.model.data());
+}
+
+void BasicRenderContent::bindDescriptorSets(
+    vk::CommandBuffer cmdBuffer, const vk::PipelineLayout &pipelineLayout,
+    int frameIndex) {
+    uint32_t dynamicOffset =
+        static_cast<uint32_t>(modelMatrixSlices[frameIndex].offset);
+    cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+                                 pipelineLayout, 0, descriptorSets[0],
+                                 dynamicOffset);
+    cmdBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex,
+                            0, sizeof(sceneMat), &sceneMat);
+}
+
+void BasicRenderContent::recordDrawCommands(vk::CommandBuffer cmdBuffer,
+                                            int frameIndex) {
+    const std::vector<vk::DrawIndexedIndirectCommand> &commands =
+        culledCommands[frameIndex];
+    if (commands.empty()) {
+        return;
+    }
+
+    std::array<vk::Buffer, 2> vertexBuffers = {vertexBufferResource.buffer,
+                                               instanceBufferResource.buffer};
+    std::array<vk::DeviceSize, 2> offsets = {0, 0};
+    cmdBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+    cmdBuffer.bindIndexBuffer(indexBufferResource.buffer, 0,
+                              vk::IndexType::eUint32);
+
+    const auto &engineInfo = renderEngine->getEngineInfo();
+    if (!engineInfo.support.isDrawIndirectFirstInstanceSupported) {
+        // the commands cannot select instances, recorded directly instead
+        for (const auto &command : commands) {
+            cmdBuffer.drawIndexed(command.indexCount, command.instanceCount,
+                                  command.firstIndex, command.vertexOffset,
+                                  command.firstInstance);
+        }
+        return;
+    }
+
+    const vk::Buffer &indirectBuffer = indirectCommandArena->getBuffer();
+    const vk::DeviceSize sliceOffset = indirectCommandSlices[frameIndex].offset;
+    const uint32_t stride = sizeof(vk::DrawIndexedIndirectCommand);
+    const uint32_t numOfCommands = static_cast<uint32_t>(commands.size());
+
+    const uint32_t maxDrawCount =
+        engineInfo.support.isMultiDrawIndirectSupported
+            ? std::max(engineInfo.limit.maxDrawIndirectCount, 1u)
+            : 1;
+    for (uint32_t first = 0; first < numOfCommands; first += maxDrawCount) {
+        uint32_t drawCount = std::min(numOfCommands - first, maxDrawCount);
+        cmdBuffer.drawIndexedIndirect(indirectBuffer,
+                                      sliceOffset + first * stride, drawCount,
+                                      stride);
+    }
 }
 
 void BasicRenderContent::uploadIndexBuffer() {
@@ -219,11 +499,13 @@ void BasicRenderContent::uploadIndexBuffer() {
 
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Uploading IndexBuffer...";
 
-    indexBufferResource.release(*renderEngine->getVmaAllocator());
+    releaseStagedBuffer(stagedIndexBufferResource);
 
-    uploadViaStagingBuffer(indices.data(), indexBufferResource,
-                           vk::BufferUsageFlagBits::eIndexBuffer,
-                           sizeof(indices[0]) * indices.size(), renderEngine);
+    stagedUploadTicket = uploadViaStagingBuffer(
+        indices.data(), stagedIndexBufferResource,
+        vk::BufferUsageFlagBits::eIndexBuffer,
+        sizeof(indices[0]) * indices.size(), renderEngine);
+    stagedNumOfIndex = indices.size();
 
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "IndexBuffer has been uploaded.";
 }
@@ -236,32 +518,83 @@ void BasicRenderContent::uploadVertexBuffer() {
 
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Uploading VertexBuffer...";
 
-    vertexBufferResource.release(*renderEngine->getVmaAllocator());
+    releaseStagedBuffer(stagedVertexBufferResource);
 
-    uploadViaStagingBuffer(
-        BasicVertex::convertToDataVector(vertices).data(), vertexBufferResource,
+    // already in the device format, copied to the staging ring directly
+    stagedUploadTicket = uploadViaStagingBuffer(
+        vertices.data(), stagedVertexBufferResource,
         vk::BufferUsageFlagBits::eVertexBuffer,
-        sizeof(BasicVertex::Data) * vertices.size(), renderEngine);
+        sizeof(BasicVertex) * vertices.size(), renderEngine);
 
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "VertexBuffer has been uploaded.";
 }
 
-const size_t BasicRenderContent::getNumOfIndex() { return indices.size(); }
+void BasicRenderContent::uploadInstanceBuffer() {
+    // the draws are replaced even if there is nothing to draw
+    stagedDraws = pendingDraws;
+    stagedInstances = instances;
+    drawsStaged = true;
+
+    if (instances.empty()) {
+        LOG(INFO) << "Instance array is empty. Stopping instanceBuffer upload.";
+        return;
+    }
+
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Uploading InstanceBuffer...";
+
+    releaseStagedBuffer(stagedInstanceBufferResource);
+
+    stagedUploadTicket = uploadViaStagingBuffer(
+        instances.data(), stagedInstanceBufferResource,
+        vk::BufferUsageFlagBits::eVertexBuffer,
+        sizeof(BasicInstance) * instances.size(), renderEngine);
+
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "InstanceBuffer has been uploaded.";
+}
+
+void BasicRenderContent::commitUploadedBuffers() {
+    RenderContent::commitUploadedBuffers();
+    numOfIndex = stagedNumOfIndex;
+
+    if (stagedInstanceBufferResource.buffer) {
+        retireBuffer(instanceBufferResource);
+        instanceBufferResource = stagedInstanceBufferResource;
+        stagedInstanceBufferResource = {};
+    }
+    if (drawsStaged) {
+        draws = std::move(stagedDraws);
+        drawnInstances = std::move(stagedInstances);
+        stagedDraws.clear();
+        stagedInstances.clear();
+        hiddenGroups.clear();
+        // commands refer to the previous instances
+        for (auto &commands : culledCommands) {
+            commands.clear();
+        }
+        drawsStaged = false;
+    }
+}
+
+const size_t BasicRenderContent::getNumOfIndex() { return numOfIndex; }
 
 // Demo ----------
 
 void BasicRenderContent::setDemoShape() {
     shapes::SingleColorCube cube(1.0, 1.0, 1.0, {0, 0, 0}, {1.0, 1.0, 1.0}, 0);
 
-    setVertices(cube.getVertices());
-    setIndices(cube.getIndices());
+    setVertices({});
+    setIndices({});
+    Mesh mesh = addMesh(cube.getVertices(), cube.getIndices());
+
+    clearInstances();
+    addInstances(mesh, {BasicInstance(0)});
 }
 
 void BasicRenderContent::updateDemoUBO(std::shared_ptr<Window> window) {
-    BasicModelMatUBO modelMat;
-    modelMat.model[0] = glm::mat4(1.0);
+    BasicModelMatSSBO modelMat;
+    modelMat.model.push_back(glm::mat4(1.0));
 
-    BasicSceneMatUBO sceneMat;
+    BasicSceneMatPushConstant sceneMat;
     sceneMat.view =
         glm::lookAt({2.0, 2.0, 4.0} /* eye */, {0.0, 0.0, 0.0} /* center */,
                     glm::vec3(0.0, 0.0, 1.0) /* up */);
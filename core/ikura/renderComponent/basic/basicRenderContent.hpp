@@ -1,35 +1,145 @@
 #pragma once
 
+#include <memory>
+
 #include "../renderContent.hpp"
+#include "../uniformArena.hpp"
 
 namespace ikura {
 // Forward declearation
 class Window;
 
 class BasicRenderContent : public RenderContent {
+  public:
+    /// Range of a mesh in the vertex / index buffers
+    struct Mesh {
+        uint32_t firstIndex = 0;
+        uint32_t numOfIndex = 0;
+        int32_t vertexOffset = 0;
+        // Bounding sphere around the vertices. The radius is negative if some
+        // vertices have a GroupID other than 0, then the mesh is never culled.
+        glm::vec3 boundingCenter = glm::vec3(0.0);
+        float boundingRadius = -1.0f;
+    };
+
+    /// Instances of the last frame passed to cullInstances()
+    struct CullingStatistics {
+        uint32_t numOfInstances = 0;
+        uint32_t numOfHiddenInstances = 0;
+        uint32_t numOfCulledInstances = 0;
+        uint32_t numOfDrawCommands = 0;
+    };
+
   protected:
+    /// Instances added by one addInstances() call
+    struct InstancedDraw {
+        Mesh mesh;
+        uint32_t firstInstance;
+        uint32_t numOfInstances;
+    };
+
     std::vector<BasicVertex> vertices;
     std::vector<BasicIndex> indices;
+    // Indices in the drawn / uploaded index buffer
+    size_t numOfIndex = 0;
+    size_t stagedNumOfIndex = 0;
+
+    // Instances ----------
+    std::vector<BasicInstance> instances;
+    BufferResource instanceBufferResource;
+    BufferResource stagedInstanceBufferResource;
+    // Drawn / added / uploaded draws
+    std::vector<InstancedDraw> draws;
+    std::vector<InstancedDraw> pendingDraws;
+    std::vector<InstancedDraw> stagedDraws;
+    bool drawsStaged = false;
+    // Copies of the drawn / uploaded instances, to look up their groups
+    std::vector<BasicInstance> drawnInstances;
+    std::vector<BasicInstance> stagedInstances;
+
+    // Groups whose instances are not drawn, [GroupID]
+    std::vector<bool> hiddenGroups;
 
-    void setupUniformBuffers();
+    // Indirect draw commands of all frames, written by cullInstances() ----
+    std::unique_ptr<UniformArena> indirectCommandArena;
+    std::vector<UniformArena::Slice> indirectCommandSlices;
+    // Commands each slice can hold
+    size_t indirectCommandCapacity = 0;
+    // Host copies of the commands written to each slice, [frame]
+    std::vector<std::vector<vk::DrawIndexedIndirectCommand>> culledCommands;
+
+    bool frustumCullingEnabled = true;
+    CullingStatistics cullingStatistics;
+
+    // Model matrices of all frames, modelMatrixSlices[frame]
+    std::unique_ptr<UniformArena> modelMatrixArena;
+    std::vector<UniformArena::Slice> modelMatrixSlices;
+    // Model matrices each slice can hold
+    size_t modelMatrixCapacity = 0;
+
+    // Pushed when the draw commands are recorded
+    BasicSceneMatPushConstant sceneMat{};
+
+    void setupModelMatrixArena(size_t capacity);
+    void setupIndirectCommandArena(size_t capacity);
     void setupDescriptorSets();
+    void updateModelMatrixDescriptorSet();
 
   public:
     BasicRenderContent(std::shared_ptr<RenderEngine> renderEngine,
                        vk::DescriptorSetLayout descriptorSetLayout,
                        int numOfFrames);
+    ~BasicRenderContent() override;
 
     void addVertices(const std::vector<BasicVertex> &vertices);
     void addIndices(const std::vector<BasicIndex> &indices);
     void setVertices(const std::vector<BasicVertex> &vertices);
     void setIndices(const std::vector<BasicIndex> &indices);
+    /// Append a mesh whose indices start from 0. It is drawn only through
+    /// addInstances().
+    Mesh addMesh(const std::vector<BasicVertex> &vertices,
+                 const std::vector<BasicIndex> &indices);
+
+    /// Draw `mesh` once for each of `instances`.
+    void addInstances(const Mesh &mesh,
+                      const std::vector<BasicInstance> &instances);
+    void clearInstances();
+
+    /// Skip the instances of group `id` when drawing. Visibilities are reset
+    /// when uploaded instances are committed.
+    void setGroupVisible(GroupID id, bool visible);
+    bool isGroupVisible(GroupID id) const;
+
+    /// Write the draw commands of frame `frameIndex`, skipping hidden groups
+    /// and instances outside the view frustum of the scene matrix.
+    /// `modelMatrices` must hold the matrices of all drawn groups, [GroupID].
+    /// Frames are not drawn until they are culled after a commit.
+    void cullInstances(int frameIndex, const glm::mat4 *modelMatrices);
+    void setFrustumCullingEnabled(bool enabled);
+    const CullingStatistics &getCullingStatistics() const;
 
-    void updateUniformBuffer(int frameIndex, BasicModelMatUBO &modelMatUBO,
-                             BasicSceneMatUBO &sceneMatUBO);
+    glm::mat4 *getMappedModelMatrices(int frameIndex,
+                                      size_t numOfModelMatrices);
+    void flushModelMatrices(int frameIndex, size_t numOfModelMatrices);
+    void setSceneMatrix(const BasicSceneMatPushConstant &sceneMat);
+    /// Copy `modelMatSSBO` with getMappedModelMatrices(), set the scene
+    /// matrix and cull instances with them.
+    void updateUniformBuffer(int frameIndex,
+                             const BasicModelMatSSBO &modelMatSSBO,
+                             const BasicSceneMatPushConstant &sceneMat);
 
     // Implementation of virtual functions ----------
+    void bindDescriptorSets(vk::CommandBuffer cmdBuffer,
+                            const vk::PipelineLayout &pipelineLayout,
+                            int frameIndex) override;
+    void recordDrawCommands(vk::CommandBuffer cmdBuffer,
+                            int frameIndex) override;
     void uploadVertexBuffer() override;
     void uploadIndexBuffer() override;
+    /// Upload the instances along with their draws. Meshes can be drawn
+    /// with other instances without uploading the vertices again.
+    void uploadInstanceBuffer();
+    void commitUploadedBuffers() override;
     const size_t getNumOfIndex() override;
 
     // Demo ----------
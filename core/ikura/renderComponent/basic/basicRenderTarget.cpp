@@ -4,8 +4,10 @@
 
 #include "../../common/logLevels.hpp"
 #include "../../common/renderPrimitiveTypes.hpp"
-#include "../../misc/shaderCodes.hpp"
+#include "../../common/uniformBufferInfo.hpp"
 #include "../../util/shaderUtils.hpp"
+#include "shaders/basic.frag.hpp"
+#include "shaders/basic.vert.hpp"
 
 namespace ikura {
 void BasicRenderTarget::setupRenderPass() {
@@ -168,25 +170,17 @@ void BasicRenderTarget::setupFrameBuffers() {
         << "Default FrameBuffers has been created.";
 }
 
+/// Does not log, as it runs on another thread while the caller is logging.
+/// Callers log the creation instead.
 void BasicRenderTarget::setupGraphicsPipeline() {
-    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Creating default GraphicsPipeline...";
-
     // ShaderModules ----------
-    //    auto vertShaderModule = createShaderModuleFromFile(
-    //        createResourceDirectoryPath(std::filesystem::path("shaders") /
-    //        "vert.spv"), renderEngine->getDevice());
-    //    auto fragShaderModule = createShaderModuleFromFile(
-    //        createResourceDirectoryPath(std::filesystem::path("shaders") /
-    //        "frag.spv"), renderEngine->getDevice());
-
-    auto vertShader = compileShader(ikura::VERTEX_SHADER_CODE, EShLangVertex);
-    auto vertShaderModule =
-        createShaderModule(vertShader, renderEngine->getDevice());
-
-    auto fragShader =
-        compileShader(ikura::FRAGMENT_SHADER_CODE, EShLangFragment);
-    auto fragShaderModule =
-        createShaderModule(fragShader, renderEngine->getDevice());
+    // compiled from shaders/basic.{vert,frag} at build time
+    auto vertShaderModule = createShaderModule(
+        shaders::BASIC_VERT_SPIRV, sizeof(shaders::BASIC_VERT_SPIRV),
+        renderEngine->getDevice());
+    auto fragShaderModule = createShaderModule(
+        shaders::BASIC_FRAG_SPIRV, sizeof(shaders::BASIC_FRAG_SPIRV),
+        renderEngine->getDevice());
 
     vk::PipelineShaderStageCreateInfo vertShaderStageCI{};
     vertShaderStageCI.stage = vk::ShaderStageFlagBits::eVertex;
@@ -201,13 +195,22 @@ void BasicRenderTarget::setupGraphicsPipeline() {
     std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {
         vertShaderStageCI, fragShaderStageCI};
 
-    auto bindingDescription = BasicVertex::getBindingDescription();
+    // per-vertex and per-instance bindings
+    std::array<vk::VertexInputBindingDescription, 2> bindingDescriptions = {
+        BasicVertex::getBindingDescription(),
+        BasicInstance::getBindingDescription()};
     auto attributeDescriptions = BasicVertex::getAttributeDescriptions();
+    auto instanceAttributeDescriptions =
+        BasicInstance::getAttributeDescriptions();
+    attributeDescriptions.insert(attributeDescriptions.end(),
+                                 instanceAttributeDescriptions.begin(),
+                                 instanceAttributeDescriptions.end());
 
     // Pipeline input states ----------
     vk::PipelineVertexInputStateCreateInfo vertInputStateCI{};
-    vertInputStateCI.vertexBindingDescriptionCount = 1;
-    vertInputStateCI.pVertexBindingDescriptions = &bindingDescription;
+    vertInputStateCI.vertexBindingDescriptionCount =
+        static_cast<uint32_t>(bindingDescriptions.size());
+    vertInputStateCI.pVertexBindingDescriptions = bindingDescriptions.data();
     vertInputStateCI.vertexAttributeDescriptionCount =
         static_cast<uint32_t>(attributeDescriptions.size());
     vertInputStateCI.pVertexAttributeDescriptions =
@@ -290,11 +293,16 @@ void BasicRenderTarget::setupGraphicsPipeline() {
     colorBlendStateCI.blendConstants[3] = 0.0f;
 
     // Pipeline layout ----------
+    vk::PushConstantRange sceneMatPushConstantRange{};
+    sceneMatPushConstantRange.stageFlags = vk::ShaderStageFlagBits::eVertex;
+    sceneMatPushConstantRange.offset = 0;
+    sceneMatPushConstantRange.size = sizeof(BasicSceneMatPushConstant);
+
     vk::PipelineLayoutCreateInfo pipelineLayoutCI{};
     pipelineLayoutCI.setLayoutCount = 1;
     pipelineLayoutCI.pSetLayouts = &descriptorSetLayout;
-    pipelineLayoutCI.pushConstantRangeCount = 0;
-    pipelineLayoutCI.pPushConstantRanges = nullptr;
+    pipelineLayoutCI.pushConstantRangeCount = 1;
+    pipelineLayoutCI.pPushConstantRanges = &sceneMatPushConstantRange;
 
     graphicsPipelineLayout =
         renderEngine->getDevice().createPipelineLayout(pipelineLayoutCI);
@@ -321,7 +329,7 @@ void BasicRenderTarget::setupGraphicsPipeline() {
     graphicsPipelineCI.basePipelineIndex = -1;
 
     auto result = renderEngine->getDevice().createGraphicsPipeline(
-        VK_NULL_HANDLE, graphicsPipelineCI);
+        renderEngine->getPipelineCache(), graphicsPipelineCI);
     switch (result.result) {
     case vk::Result::eErrorOutOfHostMemory:
         throw std::runtime_error(
@@ -341,9 +349,6 @@ void BasicRenderTarget::setupGraphicsPipeline() {
 
     renderEngine->getDevice().destroyShaderModule(vertShaderModule, nullptr);
     renderEngine->getDevice().destroyShaderModule(fragShaderModule, nullptr);
-
-    VLOG(VLOG_LV_3_PROCESS_TRACKING)
-        << "Default GraphicsPipeline has been created.";
 }
 
 BasicRenderTarget::BasicRenderTarget(
@@ -356,9 +361,14 @@ BasicRenderTarget::BasicRenderTarget(
                    descriptorSetLayout, renderImages, numOfFrames) {
 
     setupRenderPass();
+    // The pipeline only depends on the RenderPass, so it is created on
+    // another thread while the rest of the window is being set up.
+    // Its completion is logged by waitForGraphicsPipeline().
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Creating default GraphicsPipeline...";
+    graphicsPipelineSetup = std::async(std::launch::async,
+                                       [this]() { setupGraphicsPipeline(); });
     setupImageResources();
     setupFrameBuffers();
-    setupGraphicsPipeline();
 }
 
 void BasicRenderTarget::recreateResourcesForSwapChainRecreation(
@@ -379,7 +389,10 @@ void BasicRenderTarget::recreateResourcesForSwapChainRecreation(
 
     setupImageResources();
     setupRenderPass();
+    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Creating default GraphicsPipeline...";
     setupGraphicsPipeline();
+    VLOG(VLOG_LV_3_PROCESS_TRACKING)
+        << "Default GraphicsPipeline has been created.";
     setupFrameBuffers();
 }
 } // namespace ikura
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "./renderContent.hpp"
 
+#include <cassert>
+
 #include <vulkan/vulkan.hpp>
 
 #include <easylogging++.h>
@@ -29,19 +31,16 @@ RenderContent::~RenderContent() {
     VLOG(VLOG_LV_3_PROCESS_TRACKING)
         << "Default DescriptorPool has been destroyed.";
 
-    VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Destroying default UniformBuffers...";
-    for (auto &resources : uniformBufferResources) {
-        for (auto &r : resources) {
-            r.release(*renderEngine->getVmaAllocator());
-        }
-    }
-    VLOG(VLOG_LV_3_PROCESS_TRACKING)
-        << "Default UniformBuffers has been destroyed.";
-
     VLOG(VLOG_LV_3_PROCESS_TRACKING)
         << "Destroying VertexBuffer and IndexBuffer...";
     vertexBufferResource.release(*renderEngine->getVmaAllocator());
     indexBufferResource.release(*renderEngine->getVmaAllocator());
+    releaseStagedBuffer(stagedVertexBufferResource);
+    releaseStagedBuffer(stagedIndexBufferResource);
+    // the device is idle when the content is destroyed
+    for (auto &retiredBuffer : retiredBuffers) {
+        retiredBuffer.resource.release(*renderEngine->getVmaAllocator());
+    }
     VLOG(VLOG_LV_3_PROCESS_TRACKING)
         << "VertexBuffer and IndexBuffer have been destroyed.";
 }
@@ -50,6 +49,54 @@ void RenderContent::uploadVertexBuffer() {}
 
 void RenderContent::uploadIndexBuffer() {}
 
+bool RenderContent::isUploadCompleted() {
+    return renderEngine->getUploadManager().isCompleted(stagedUploadTicket);
+}
+
+void RenderContent::commitUploadedBuffers() {
+    renderEngine->getUploadManager().wait(stagedUploadTicket);
+
+    if (stagedVertexBufferResource.buffer) {
+        retireBuffer(vertexBufferResource);
+        vertexBufferResource = stagedVertexBufferResource;
+        stagedVertexBufferResource = {};
+    }
+    if (stagedIndexBufferResource.buffer) {
+        retireBuffer(indexBufferResource);
+        indexBufferResource = stagedIndexBufferResource;
+        stagedIndexBufferResource = {};
+    }
+}
+
+void RenderContent::releaseRetiredBuffers(int frameIndex) {
+    auto it = retiredBuffers.begin();
+    while (it != retiredBuffers.end()) {
+        it->pendingFrameMask &= ~(1U << frameIndex);
+        if (it->pendingFrameMask == 0) {
+            it->resource.release(*renderEngine->getVmaAllocator());
+            it = retiredBuffers.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void RenderContent::bindDescriptorSets(vk::CommandBuffer cmdBuffer,
+                                       const vk::PipelineLayout &pipelineLayout,
+                                       int frameIndex) {
+    cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
+                                 pipelineLayout, 0, descriptorSets[frameIndex],
+                                 nullptr);
+}
+
+void RenderContent::recordDrawCommands(vk::CommandBuffer cmdBuffer,
+                                       int frameIndex) {
+    cmdBuffer.bindVertexBuffers(0, {vertexBufferResource.buffer}, {0});
+    cmdBuffer.bindIndexBuffer(indexBufferResource.buffer, 0,
+                              vk::IndexType::eUint32);
+    cmdBuffer.drawIndexed(getNumOfIndex(), 1, 0, 0, 0);
+}
+
 const vk::Buffer &RenderContent::getVertexBuffer() const {
     return vertexBufferResource.buffer;
 }
@@ -65,59 +112,55 @@ RenderContent::getDescriptorSets(int index) {
 
 const size_t RenderContent::getNumOfIndex() { return 0; }
 
-void RenderContent::uploadViaStagingBuffer(
+UploadManager::Ticket RenderContent::uploadViaStagingBuffer(
     void *srcData, BufferResource &dstBufferResource,
     vk::BufferUsageFlags dstBufferUsage, vk::DeviceSize bufferSize,
     std::shared_ptr<RenderEngine> renderEngine) {
 
-    // Staging buffer allocation ----------
-    BufferResource stagingBufferResource;
-    vk::BufferCreateInfo stagingBufferCI{};
-    stagingBufferCI.size = bufferSize;
-    stagingBufferCI.usage = vk::BufferUsageFlagBits::eTransferSrc;
-
-    VmaAllocationCreateInfo allocCI{};
-    allocCI.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
-    allocCI.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
-                    VMA_ALLOCATION_CREATE_MAPPED_BIT;
-    VmaAllocationInfo stagingBufferAllocInfo{};
-
-    VkBuffer vkBuffer;
-    auto vkBufferCI = (VkBufferCreateInfo)stagingBufferCI;
-    vmaCreateBuffer(*renderEngine->getVmaAllocator(), &vkBufferCI, &allocCI,
-                    &vkBuffer, &stagingBufferResource.alloc,
-                    &stagingBufferAllocInfo);
-    stagingBufferResource.buffer = (vk::Buffer)vkBuffer;
-
     // Destination buffer allocation ----------
     vk::BufferCreateInfo dstBufferCI{};
     dstBufferCI.size = bufferSize;
     dstBufferCI.usage = dstBufferUsage | vk::BufferUsageFlagBits::eTransferDst;
     dstBufferCI.sharingMode = vk::SharingMode::eExclusive;
 
-    allocCI = {};
+    VmaAllocationCreateInfo allocCI{};
     allocCI.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
 
-    vkBufferCI = (VkBufferCreateInfo)dstBufferCI;
+    VkBuffer vkBuffer;
+    auto vkBufferCI = (VkBufferCreateInfo)dstBufferCI;
     vmaCreateBuffer(*renderEngine->getVmaAllocator(), &vkBufferCI, &allocCI,
                     &vkBuffer, &dstBufferResource.alloc, nullptr);
     dstBufferResource.buffer = (vk::Buffer)vkBuffer;
 
     // Copy ----------
-    // srcData to staging buffer
-    memcpy(stagingBufferAllocInfo.pMappedData, srcData, bufferSize);
-
-    // staging buffer to destination buffer
-    auto cmdBuffer = renderEngine->beginSingleTimeCommands();
-
-    vk::BufferCopy copy;
-    copy.size = bufferSize;
-    cmdBuffer.copyBuffer(stagingBufferResource.buffer, dstBufferResource.buffer,
-                         copy);
+    // Recorded into the pending upload batch, which is submitted before the
+    // next frame is drawn.
+    return renderEngine->getUploadManager().enqueueCopy(
+        srcData, bufferSize, dstBufferResource.buffer);
+}
 
-    // submit command
-    renderEngine->endSingleTimeCommands(cmdBuffer);
+/**
+ * @brief Release a staged buffer which is not committed, waiting for its
+ * upload first.
+ */
+void RenderContent::releaseStagedBuffer(BufferResource &stagedBufferResource) {
+    if (!stagedBufferResource.buffer) {
+        return;
+    }
+    renderEngine->getUploadManager().wait(stagedUploadTicket);
+    stagedBufferResource.release(*renderEngine->getVmaAllocator());
+    stagedBufferResource = {};
+}
 
-    stagingBufferResource.release(*renderEngine->getVmaAllocator());
+/**
+ * @brief Release `bufferResource` once all frames submitted so far have
+ * completed, instead of waiting for the device to be idle.
+ */
+void RenderContent::retireBuffer(const BufferResource &bufferResource) {
+    if (!bufferResource.buffer) {
+        return;
+    }
+    assert(numOfFrames <= 32);
+    retiredBuffers.push_back({bufferResource, (1U << numOfFrames) - 1});
 }
 } // namespace ikura
\ No newline at end of file
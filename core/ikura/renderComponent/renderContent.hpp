@@ -29,8 +29,19 @@ class RenderContent {
     // Buffers ----------
     BufferResource vertexBufferResource;
     BufferResource indexBufferResource;
-    // uniformBuffers[frame][set]
-    std::vector<std::vector<BufferResource>> uniformBufferResources;
+    // Uploaded buffers replacing the above by commitUploadedBuffers()
+    BufferResource stagedVertexBufferResource;
+    BufferResource stagedIndexBufferResource;
+    UploadManager::Ticket stagedUploadTicket = 0;
+    /// Buffers replaced by commitUploadedBuffers(), released by
+    /// releaseRetiredBuffers() once no frame in flight can read them.
+    struct RetiredBuffer {
+        BufferResource resource;
+        /// Bit `i` is set until frame `i` submitted before the buffer was
+        /// retired has completed.
+        uint32_t pendingFrameMask;
+    };
+    std::vector<RetiredBuffer> retiredBuffers;
 
     // about DescriptorSet ----------
     vk::DescriptorPool descriptorPool;
@@ -42,18 +53,41 @@ class RenderContent {
     int numOfFrames;
 
     // Functions ==========
-    static void
+    static UploadManager::Ticket
     uploadViaStagingBuffer(void *srcData, BufferResource &dstBufferResource,
                            vk::BufferUsageFlags dstBufferUsage,
                            vk::DeviceSize bufferSize,
                            std::shared_ptr<RenderEngine> renderEngine);
+    void releaseStagedBuffer(BufferResource &stagedBufferResource);
+    void retireBuffer(const BufferResource &bufferResource);
 
   public:
     virtual ~RenderContent();
 
     // Upload to GPU ----------
+    // Uploaded buffers are not drawn until commitUploadedBuffers() is called,
+    // so the current ones can be drawn while they stream in.
     virtual void uploadVertexBuffer();
     virtual void uploadIndexBuffer();
+    bool isUploadCompleted();
+    /// Replace the drawn buffers with the uploaded ones, blocking until the
+    /// upload completes. The current buffers are released once the frames
+    /// in flight have completed (see releaseRetiredBuffers()).
+    virtual void commitUploadedBuffers();
+    /// Release retired buffers no longer read by any frame. Call after
+    /// waiting for the fence of frame `frameIndex`.
+    void releaseRetiredBuffers(int frameIndex);
+
+    // Record commands ----------
+    /// Bind descriptor sets (and push constants) for drawing frame
+    /// `frameIndex`.
+    virtual void bindDescriptorSets(vk::CommandBuffer cmdBuffer,
+                                    const vk::PipelineLayout &pipelineLayout,
+                                    int frameIndex);
+    /// Bind the vertex / index buffers and record the draw calls of frame
+    /// `frameIndex`.
+    virtual void recordDrawCommands(vk::CommandBuffer cmdBuffer,
+                                    int frameIndex);
 
     // Getter ----------
     virtual const size_t getNumOfIndex();
@@ -9,7 +9,6 @@
 #include "../window/nativeWindow/nativeWindow.hpp"
 
 #include "../common/logLevels.hpp"
-#include "../misc/shaderCodes.hpp"
 
 #include <tinyfiledialogs/tinyfiledialogs.h>
 
@@ -84,14 +83,27 @@ const vk::Framebuffer &RenderTarget::getFramebuffer(int imageIndex) const {
 }
 
 const vk::Pipeline &RenderTarget::getGraphicsPipeline() const {
+    waitForGraphicsPipeline();
     return graphicsPipeline;
 }
 
 const vk::PipelineLayout &RenderTarget::getGraphicsPipelineLayout() const {
+    waitForGraphicsPipeline();
     return graphicsPipelineLayout;
 }
 
+void RenderTarget::waitForGraphicsPipeline() const {
+    if (graphicsPipelineSetup.valid()) {
+        graphicsPipelineSetup.get();
+        // logged here, as the pipeline is created without logging
+        VLOG(VLOG_LV_3_PROCESS_TRACKING)
+            << "Default GraphicsPipeline has been created.";
+    }
+}
+
 void RenderTarget::destroyResourcesForSwapChainRecreation() {
+    waitForGraphicsPipeline();
+
     colorImageResource.release(renderEngine->getDevice(),
                                *renderEngine->getVmaAllocator());
     depthImageResource.release(renderEngine->getDevice(),
@@ -138,6 +150,10 @@ RenderTarget::RenderTarget(const std::shared_ptr<RenderEngine> renderEngine,
 }
 
 RenderTarget::~RenderTarget() {
+    if (graphicsPipelineSetup.valid()) {
+        graphicsPipelineSetup.wait();
+    }
+
     VLOG(VLOG_LV_3_PROCESS_TRACKING) << "Destroying default GraphicsPipelne...";
     renderEngine->getDevice().destroyPipeline(graphicsPipeline);
     renderEngine->getDevice().destroyPipelineLayout(graphicsPipelineLayout);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <future>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -31,6 +32,8 @@ class RenderTarget {
     std::vector<vk::CommandBuffer> renderCmdBuffers;
     vk::PipelineLayout graphicsPipelineLayout;
     vk::Pipeline graphicsPipeline;
+    // Valid while the GraphicsPipeline is being created on another thread
+    mutable std::future<void> graphicsPipelineSetup;
     vk::RenderPass renderPass;
     std::vector<vk::Framebuffer> frameBuffers;
 
@@ -54,6 +57,9 @@ class RenderTarget {
     // Methods ==========
     virtual void createSyncObjects();
     virtual void createRenderCmdBuffers();
+    /// Rethrows the exception thrown while creating the GraphicsPipeline.
+    /// Logs the completion on the calling thread.
+    void waitForGraphicsPipeline() const;
 
     // helper functions ----------
     static vk::Format
@@ -0,0 +1,80 @@
+#include "./uniformArena.hpp"
+
+#include <easylogging++.h>
+
+#include "../common/logLevels.hpp"
+
+namespace ikura {
+UniformArena::UniformArena(std::shared_ptr<RenderEngine> renderEngine,
+                           vk::DeviceSize capacity, vk::BufferUsageFlags usage,
+                           vk::DeviceSize alignment) {
+    this->renderEngine = renderEngine;
+    this->capacity = capacity;
+    this->alignment = alignment;
+
+    vk::BufferCreateInfo bufferCI{};
+    bufferCI.size = capacity;
+    bufferCI.usage = usage;
+    bufferCI.sharingMode = vk::SharingMode::eExclusive;
+
+    VmaAllocationCreateInfo allocCI{};
+    allocCI.usage = VMA_MEMORY_USAGE_AUTO;
+    allocCI.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                    VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    auto vkBufferCI = (VkBufferCreateInfo)bufferCI;
+    VkBuffer vkBuffer;
+    VmaAllocationInfo allocInfo{};
+
+    auto result =
+        vmaCreateBuffer(*renderEngine->getVmaAllocator(), &vkBufferCI,
+                        &allocCI, &vkBuffer, &alloc, &allocInfo);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create UniformArena buffer.");
+    }
+
+    buffer = vk::Buffer(vkBuffer);
+    mappedData = allocInfo.pMappedData;
+
+    VLOG(VLOG_LV_3_PROCESS_TRACKING)
+        << "UniformArena of " << capacity << " bytes has been created.";
+}
+
+UniformArena::~UniformArena() {
+    vmaDestroyBuffer(*renderEngine->getVmaAllocator(), (VkBuffer)buffer,
+                     alloc);
+}
+
+UniformArena::Slice UniformArena::allocate(vk::DeviceSize size) {
+    vk::DeviceSize offset = alignSize(usedSize, alignment);
+    if (offset + size > capacity) {
+        throw std::runtime_error("UniformArena is out of space.");
+    }
+
+    Slice slice;
+    slice.offset = offset;
+    slice.size = size;
+    slice.mappedData = static_cast<char *>(mappedData) + offset;
+
+    usedSize = offset + size;
+    return slice;
+}
+
+void UniformArena::reset() { usedSize = 0; }
+
+void UniformArena::flush(const Slice &slice, vk::DeviceSize size) const {
+    vmaFlushAllocation(*renderEngine->getVmaAllocator(), alloc, slice.offset,
+                       size);
+}
+
+const vk::Buffer &UniformArena::getBuffer() const { return buffer; }
+
+vk::DeviceSize UniformArena::getCapacity() const { return capacity; }
+
+vk::DeviceSize UniformArena::getAlignment() const { return alignment; }
+
+vk::DeviceSize UniformArena::alignSize(vk::DeviceSize size,
+                                       vk::DeviceSize alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+} // namespace ikura
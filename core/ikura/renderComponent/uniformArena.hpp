@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+
+#include <vulkan/vulkan.hpp>
+
+#include "../engine/renderEngine/renderEngine.hpp"
+
+namespace ikura {
+/**
+ * @brief One persistently mapped host-visible buffer handing out aligned
+ * slices of it.
+ *
+ * Slices are allocated from the front and released all at once by reset().
+ * Descriptors bind the whole buffer and select a slice by its offset.
+ */
+class UniformArena {
+  public:
+    struct Slice {
+        vk::DeviceSize offset = 0;
+        vk::DeviceSize size = 0;
+        void *mappedData = nullptr;
+    };
+
+  private:
+    std::shared_ptr<RenderEngine> renderEngine;
+    vk::Buffer buffer;
+    VmaAllocation alloc;
+    void *mappedData = nullptr;
+
+    vk::DeviceSize capacity;
+    vk::DeviceSize alignment;
+    vk::DeviceSize usedSize = 0;
+
+  public:
+    UniformArena(std::shared_ptr<RenderEngine> renderEngine,
+                 vk::DeviceSize capacity, vk::BufferUsageFlags usage,
+                 vk::DeviceSize alignment);
+    ~UniformArena();
+
+    UniformArena(const UniformArena &) = delete;
+    UniformArena &operator=(const UniformArena &) = delete;
+
+    /// Throws std::runtime_error if the arena has no room for `size` bytes.
+    Slice allocate(vk::DeviceSize size);
+    /// Release all slices.
+    void reset();
+    /// Make the first `size` bytes written to `slice` visible to the device.
+    /// Nothing is done for host-coherent memory.
+    void flush(const Slice &slice, vk::DeviceSize size) const;
+
+    const vk::Buffer &getBuffer() const;
+    vk::DeviceSize getCapacity() const;
+    vk::DeviceSize getAlignment() const;
+
+    /// `size` rounded up to a multiple of `alignment`.
+    static vk::DeviceSize alignSize(vk::DeviceSize size,
+                                    vk::DeviceSize alignment);
+};
+} // namespace ikura
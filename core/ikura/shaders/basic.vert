@@ -0,0 +1,27 @@
+#version 450
+
+// sized to the number of groups in use
+layout(set = 0, binding = 0) readonly buffer ModelMat {
+	mat4 model[];
+} modelMat;
+
+layout(push_constant) uniform SceneMat {
+	mat4 view;
+	mat4 proj;
+} sceneMat;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in uint inId;
+// per instance
+layout(location = 3) in vec4 inInstanceOffsetScale;
+layout(location = 4) in uint inInstanceId;
+
+layout(location = 0) out vec3 flagColor;
+
+void main() {
+	vec3 pos = inInstanceOffsetScale.xyz + inInstanceOffsetScale.w * inPosition;
+	gl_Position = sceneMat.proj * sceneMat.view * modelMat.model[inId + inInstanceId] * vec4(pos, 1.0);
+
+	flagColor = inColor;
+}
@@ -1,5 +1,4 @@
 #include "./octahedronBone.hpp"
-#include "../sphere/singleColorSphere.hpp"
 
 namespace ikura {
 namespace shapes {
@@ -59,27 +58,6 @@ OctahedronBone::OctahedronBone(float length, GroupID id) : Bone(length, id) {
     for (int i = 0; i < vertices.size(); i++) {
         indices.push_back(i);
     }
-
-    // root and tip Spheres ---
-    SingleColorSphere rootSphere(length * 0.03, 10, 10,
-                                 glm::vec3(length, 0.0, 0.0),
-                                 glm::vec3(0.8, 0.8, 0.8), id);
-    SingleColorSphere tipSphere(length * 0.02, 10, 10, glm::vec3(0.0, 0.0, 0.0),
-                                glm::vec3(0.8, 0.8, 0.8), id);
-
-    BasicIndex baseIndex = static_cast<uint32_t>(vertices.size());
-    rootSphere.setBaseIndex(baseIndex);
-    baseIndex += static_cast<uint32_t>(rootSphere.getVertices().size());
-    tipSphere.setBaseIndex(baseIndex);
-
-    vertices.insert(vertices.end(), rootSphere.getVertices().begin(),
-                    rootSphere.getVertices().end());
-    vertices.insert(vertices.end(), tipSphere.getVertices().begin(),
-                    tipSphere.getVertices().end());
-    indices.insert(indices.end(), rootSphere.getIndices().begin(),
-                   rootSphere.getIndices().end());
-    indices.insert(indices.end(), tipSphere.getIndices().begin(),
-                   tipSphere.getIndices().end());
 }
 } // namespace shapes
 } // namespace ikura
\ No newline at end of file
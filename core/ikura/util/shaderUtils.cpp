@@ -4,17 +4,103 @@
 
 #include "shaderUtils.hpp"
 
+#include <cstdio>
+#include <fstream>
 #include <string>
 
+#include <easylogging++.h>
+#ifdef IKURA_RUNTIME_SHADER_COMPILER
 #include <glslang/Public/ResourceLimits.h>
 #include <glslang/Public/ShaderLang.h>
 #include <glslang/SPIRV/GlslangToSpv.h>
+#endif
 #include <vulkan/vulkan.hpp>
 
 namespace ikura {
+#ifdef IKURA_RUNTIME_SHADER_COMPILER
+namespace {
+// Bump when the compile options change so that stale SPIR-V is not reused.
+constexpr uint64_t SPIRV_CACHE_VERSION = 1;
+constexpr uint32_t SPIRV_MAGIC_NUMBER = 0x07230203;
+
+/// Initializes glslang once per process and finalizes it at exit.
+void initializeGlslangOnce() {
+    struct GlslangProcess {
+        GlslangProcess() { glslang::InitializeProcess(); }
+        ~GlslangProcess() { glslang::FinalizeProcess(); }
+    };
+    static GlslangProcess process;
+}
+
+/// 64-bit FNV-1a hash
+uint64_t hashShaderSource(const std::string &source, EShLanguage stage) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    const auto feed = [&hash](const void *data, size_t size) {
+        auto bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+
+    feed(&SPIRV_CACHE_VERSION, sizeof(SPIRV_CACHE_VERSION));
+    const int32_t stageValue = stage;
+    feed(&stageValue, sizeof(stageValue));
+    feed(source.data(), source.size());
+
+    return hash;
+}
+
+std::vector<uint32_t> readSpirvFile(const std::filesystem::path &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return {};
+    }
+
+    const auto fileSize = static_cast<size_t>(file.tellg());
+    if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0) {
+        return {};
+    }
+
+    std::vector<uint32_t> spirv(fileSize / sizeof(uint32_t));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(spirv.data()), fileSize) ||
+        spirv[0] != SPIRV_MAGIC_NUMBER) {
+        return {};
+    }
+
+    return spirv;
+}
+
+/// Written to a temporary file first so that a partial file is never read.
+void writeSpirvFile(const std::filesystem::path &path,
+                    const std::vector<uint32_t> &spirv) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(spirv.data()),
+                   spirv.size() * sizeof(uint32_t));
+        if (!file) {
+            LOG(WARNING) << "Failed to write SPIR-V cache: " << tmpPath;
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        LOG(WARNING) << "Failed to write SPIR-V cache: " << path;
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+} // namespace
+
 std::vector<uint32_t> compileShader(const std::string &source,
                                     const EShLanguage &stage) {
-    glslang::InitializeProcess();
+    initializeGlslangOnce();
 
     const char *shaderStrings[1];
     shaderStrings[0] = source.c_str();
@@ -39,19 +125,48 @@ std::vector<uint32_t> compileShader(const std::string &source,
     std::vector<uint32_t> spirv;
     glslang::GlslangToSpv(*program.getIntermediate(stage), spirv);
 
-    glslang::FinalizeProcess();
     return spirv;
 }
 
+std::vector<uint32_t>
+compileShaderWithCache(const std::string &source, const EShLanguage &stage,
+                       const std::filesystem::path &cacheDirectory) {
+    if (cacheDirectory.empty()) {
+        return compileShader(source, stage);
+    }
+
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.spv",
+                  static_cast<unsigned long long>(
+                      hashShaderSource(source, stage)));
+    const auto cachePath = cacheDirectory / fileName;
+
+    auto spirv = readSpirvFile(cachePath);
+    if (!spirv.empty()) {
+        return spirv;
+    }
+
+    spirv = compileShader(source, stage);
+    if (!spirv.empty()) {
+        writeSpirvFile(cachePath, spirv);
+    }
+    return spirv;
+}
+
+#endif
+
 vk::ShaderModule createShaderModule(const std::vector<uint32_t> &spirv,
                                     const vk::Device &device) {
-    glslang::InitializeProcess();
+    return createShaderModule(spirv.data(), spirv.size() * sizeof(uint32_t),
+                              device);
+}
 
+vk::ShaderModule createShaderModule(const uint32_t *spirv, size_t spirvSize,
+                                    const vk::Device &device) {
     vk::ShaderModuleCreateInfo createInfo;
-    createInfo.codeSize = spirv.size() * sizeof(uint32_t);
-    createInfo.pCode = spirv.data();
+    createInfo.codeSize = spirvSize;
+    createInfo.pCode = spirv;
 
-    glslang::FinalizeProcess();
     return device.createShaderModule(createInfo);
 }
 } // namespace ikura
@@ -4,17 +4,33 @@
 
 #pragma once
 
+#include <filesystem>
 #include <string>
 
+#ifdef IKURA_RUNTIME_SHADER_COMPILER
 #include <glslang/Public/ShaderLang.h>
+#endif
 #include <vulkan/vulkan.hpp>
 
 namespace ikura {
 
+#ifdef IKURA_RUNTIME_SHADER_COMPILER
+/// Returns an empty vector if compilation failed.
 std::vector<uint32_t> compileShader(const std::string &source,
                                                       const EShLanguage &stage);
 
+/// compileShader() backed by SPIR-V files in `cacheDirectory`, keyed by the
+/// hash of `source` and `stage`. Nothing is cached if `cacheDirectory` is
+/// empty.
+std::vector<uint32_t>
+compileShaderWithCache(const std::string &source, const EShLanguage &stage,
+                       const std::filesystem::path &cacheDirectory);
+#endif
+
 vk::ShaderModule createShaderModule(const std::vector<uint32_t> &spirv,
                                                      const vk::Device &device);
+/// `spirvSize` is in bytes.
+vk::ShaderModule createShaderModule(const uint32_t *spirv, size_t spirvSize,
+                                    const vk::Device &device);
 
 } // namespace ikura
\ No newline at end of file
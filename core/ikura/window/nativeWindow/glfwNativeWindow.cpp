@@ -204,6 +204,7 @@ void GlfwNativeWindow::draw() {
     }
     renderEngine->getDevice().resetFences(
         renderTarget->getRenderingFence(currentFrame));
+    renderContent->releaseRetiredBuffers(currentFrame);
 
     // Acquire swapChain image
     auto nextImage = renderEngine->getDevice().acquireNextImageKHR(
@@ -222,6 +223,9 @@ void GlfwNativeWindow::draw() {
     renderTarget->getRenderCommandBuffer(currentFrame).reset({});
     recordCommandBuffer(nextImage.value);
 
+    // Submit pending uploads ahead of the commands using them
+    renderEngine->getUploadManager().submit();
+
     // Submit command buffer
     std::array<vk::PipelineStageFlags, 1> waitStages = {
         vk::PipelineStageFlagBits::eColorAttachmentOutput};
@@ -292,20 +296,13 @@ void GlfwNativeWindow::recordCommandBuffer(uint32_t imageIndex) {
     renderTarget->getRenderCommandBuffer(currentFrame)
         .bindPipeline(vk::PipelineBindPoint::eGraphics,
                       renderTarget->getGraphicsPipeline());
-    renderTarget->getRenderCommandBuffer(currentFrame)
-        .bindVertexBuffers(0, {renderContent->getVertexBuffer()}, {0});
-    renderTarget->getRenderCommandBuffer(currentFrame)
-        .bindIndexBuffer(renderContent->getIndexBuffer(), 0,
-                         vk::IndexType::eUint32);
-    renderTarget->getRenderCommandBuffer(currentFrame)
-        .bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
-                            renderTarget->getGraphicsPipelineLayout(), 0,
-                            renderContent->getDescriptorSets(currentFrame),
-                            nullptr);
+    renderContent->bindDescriptorSets(
+        renderTarget->getRenderCommandBuffer(currentFrame),
+        renderTarget->getGraphicsPipelineLayout(), currentFrame);
 
     // Draw ----------
-    renderTarget->getRenderCommandBuffer(currentFrame)
-        .drawIndexed(renderContent->getNumOfIndex(), 1, 0, 0, 0);
+    renderContent->recordDrawCommands(
+        renderTarget->getRenderCommandBuffer(currentFrame), currentFrame);
 
     // VirtualWindows ----------
     for (auto &vWindow : virtualWindows) {
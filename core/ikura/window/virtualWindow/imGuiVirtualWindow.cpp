@@ -45,6 +45,8 @@ void ImGuiVirtualWindow::initImGuiResources(
         ikura::QueueFamilyIndices::GRAPHICS);
     initInfo.Queue = (VkQueue)renderEngine->getQueues().graphicsQueue;
     initInfo.DescriptorPool = (VkDescriptorPool)imGuiDescriptorPool;
+    initInfo.PipelineCache =
+        (VkPipelineCache)renderEngine->getPipelineCache();
     initInfo.MinImageCount = 3;
     initInfo.ImageCount = 3;
     initInfo.MSAASamples = (VkSampleCountFlagBits)renderEngine->getEngineInfo()
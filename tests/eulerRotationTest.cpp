@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "motionUtil/common.hpp"
+#include "motionUtil/eulerRotation.hpp"
+
+// exit code making CTest report the test as skipped
+#define SKIP_RETURN_CODE 77
+// max difference of matrix elements from the glm::rotate reference
+#define ROTATION_EPSILON 1e-4f
+
+namespace {
+int numOfFailures = 0;
+
+const std::array<std::array<RotationAxisEnum, 3>, 6> ROTATION_ORDERS = {{
+    {RotationAxisEnum::X, RotationAxisEnum::Y, RotationAxisEnum::Z},
+    {RotationAxisEnum::X, RotationAxisEnum::Z, RotationAxisEnum::Y},
+    {RotationAxisEnum::Y, RotationAxisEnum::X, RotationAxisEnum::Z},
+    {RotationAxisEnum::Y, RotationAxisEnum::Z, RotationAxisEnum::X},
+    {RotationAxisEnum::Z, RotationAxisEnum::X, RotationAxisEnum::Y},
+    {RotationAxisEnum::Z, RotationAxisEnum::Y, RotationAxisEnum::X},
+}};
+
+const std::array<float, 19> EDGE_CASE_ANGLES = {
+    0.0f,    90.0f,    -90.0f,  180.0f,  -180.0f, 45.0f,   -45.0f,
+    44.999f, 45.001f,  135.0f,  270.0f,  -270.0f, 360.0f,  -360.0f,
+    720.0f,  -1080.5f, 3600.0f, 7245.0f, -9999.9f};
+
+/// Rotation of a joint as calculated before the kernels, by multiplying
+/// glm::rotate() matrices in the rotation order.
+glm::mat3 calculateReferenceRotation(
+    const float *jointValues,
+    const std::array<RotationAxisEnum, 3> &rotationOrder) {
+    glm::mat4 rotation(1.0f);
+    for (RotationAxisEnum axis : rotationOrder) {
+        glm::vec3 axisVec3(0.0f);
+        axisVec3[axis] = 1.0f;
+        const float degrees =
+            jointValues[convertRotationAxisEnumToChannelEnum(axis)];
+        rotation = glm::rotate(rotation, glm::radians(degrees), axisVec3);
+    }
+    return glm::mat3(rotation);
+}
+
+/// Run the kernel of `rotationOrder` on `frameValues` and compare each joint
+/// with the reference.
+void checkKernel(const std::array<RotationAxisEnum, 3> &rotationOrder,
+                 const std::vector<float> &frameValues, size_t numOfJoints,
+                 const std::string &description) {
+    std::vector<glm::mat3> rotations(numOfJoints);
+    selectEulerRotationKernel(rotationOrder)(frameValues.data(), numOfJoints,
+                                             rotations.data());
+
+    const std::string orderStr =
+        convertRotationAxisEnumToRotationOrderStr(rotationOrder);
+    for (size_t id = 0; id < numOfJoints; id++) {
+        const float *jointValues =
+            frameValues.data() + Motion::getJointOffset(id);
+        const glm::mat3 expected =
+            calculateReferenceRotation(jointValues, rotationOrder);
+
+        float maxError = 0.0f;
+        for (int column = 0; column < 3; column++) {
+            for (int row = 0; row < 3; row++) {
+                const float error = std::abs(rotations[id][column][row] -
+                                             expected[column][row]);
+                maxError = std::max(maxError, error);
+            }
+        }
+        if (!(maxError <= ROTATION_EPSILON)) {
+            std::fprintf(stderr,
+                         "FAILED: %s, order %s, joint %zu (%g, %g, %g): "
+                         "error %g\n",
+                         description.c_str(), orderStr.c_str(), id,
+                         jointValues[ChannelEnum::Xrotation],
+                         jointValues[ChannelEnum::Yrotation],
+                         jointValues[ChannelEnum::Zrotation], maxError);
+            numOfFailures++;
+        }
+    }
+}
+} // namespace
+
+// ----------------------------------------
+// Test cases
+// ----------------------------------------
+
+/// All combinations of the edge case angles on the 3 axes.
+void testEdgeCaseAngles() {
+    const size_t numOfAngles = EDGE_CASE_ANGLES.size();
+    const size_t numOfJoints = numOfAngles * numOfAngles * numOfAngles;
+
+    std::vector<float> frameValues(numOfJoints * NUM_OF_JOINT_STATE_VALUES);
+    for (size_t id = 0; id < numOfJoints; id++) {
+        float *jointValues = frameValues.data() + Motion::getJointOffset(id);
+        jointValues[ChannelEnum::Xrotation] =
+            EDGE_CASE_ANGLES[id % numOfAngles];
+        jointValues[ChannelEnum::Yrotation] =
+            EDGE_CASE_ANGLES[id / numOfAngles % numOfAngles];
+        jointValues[ChannelEnum::Zrotation] =
+            EDGE_CASE_ANGLES[id / numOfAngles / numOfAngles];
+    }
+
+    for (const auto &rotationOrder : ROTATION_ORDERS) {
+        checkKernel(rotationOrder, frameValues, numOfJoints, "edge cases");
+    }
+}
+
+/// Random angles, with numbers of joints not filling the last SIMD batch.
+void testRandomAngles() {
+    std::mt19937 engine(12345);
+    std::uniform_real_distribution<float> smallAngle(-180.0f, 180.0f);
+    std::uniform_real_distribution<float> largeAngle(-3600.0f, 3600.0f);
+
+    for (size_t numOfJoints : {1, 3, 4, 5, 7, 8, 9, 16, 17, 100}) {
+        std::vector<float> frameValues(numOfJoints *
+                                       NUM_OF_JOINT_STATE_VALUES);
+        for (size_t id = 0; id < numOfJoints; id++) {
+            float *jointValues =
+                frameValues.data() + Motion::getJointOffset(id);
+            for (size_t i = 0; i < NUM_OF_JOINT_STATE_VALUES; i++) {
+                // position channels are ignored by the kernels
+                jointValues[i] =
+                    id % 2 == 0 ? smallAngle(engine) : largeAngle(engine);
+            }
+        }
+
+        for (const auto &rotationOrder : ROTATION_ORDERS) {
+            checkKernel(rotationOrder, frameValues, numOfJoints,
+                        std::to_string(numOfJoints) + " random joints");
+        }
+    }
+}
+
+int main() {
+#if defined(EULER_ROTATION_TEST_REQUIRES_AVX2) && defined(__GNUC__)
+    if (!__builtin_cpu_supports("avx2")) {
+        std::fprintf(stderr, "AVX2 is not supported on this CPU.\n");
+        return SKIP_RETURN_CODE;
+    }
+#endif
+
+    testEdgeCaseAngles();
+    testRandomAngles();
+
+    if (numOfFailures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", numOfFailures);
+        return 1;
+    }
+    return 0;
+}
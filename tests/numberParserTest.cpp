@@ -0,0 +1,106 @@
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+#include "util/numberParser.hpp"
+
+namespace {
+int numOfFailures = 0;
+
+void check(bool condition, const std::string &description) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", description.c_str());
+        numOfFailures++;
+    }
+}
+
+/// Parse whole `str` as size_t. Return false if not all characters are
+/// consumed.
+bool parseWholeSize(const std::string &str, size_t &value) {
+    const char *last = str.data() + str.size();
+    return parseSize(str.data(), last, value) == last;
+}
+
+/// Parse whole `str` as float. Return false if not all characters are
+/// consumed.
+bool parseWholeFloat(const std::string &str, float &value) {
+    const char *last = str.data() + str.size();
+    return parseFloat(str.data(), last, value) == last;
+}
+} // namespace
+
+// ----------------------------------------
+// parseSize
+// ----------------------------------------
+
+void testParseSize() {
+    size_t value;
+
+    check(parseWholeSize("0", value) && value == 0, "parseSize: 0");
+    check(parseWholeSize("12345", value) && value == 12345,
+          "parseSize: 12345");
+    check(parseWholeSize("007", value) && value == 7, "parseSize: 007");
+
+    const std::string max = std::to_string(SIZE_MAX);
+    check(parseWholeSize(max, value) && value == SIZE_MAX,
+          "parseSize: SIZE_MAX");
+
+    // SIZE_MAX + 1 (the last digit of SIZE_MAX is never 9)
+    std::string maxPlusOne = max;
+    maxPlusOne.back()++;
+    check(!parseWholeSize(maxPlusOne, value), "parseSize: SIZE_MAX + 1");
+    check(!parseWholeSize(max + "0", value), "parseSize: SIZE_MAX * 10");
+    check(!parseWholeSize("99999999999999999999999999999999", value),
+          "parseSize: 32 digits");
+
+    check(!parseWholeSize("", value), "parseSize: empty");
+    check(!parseWholeSize("-1", value), "parseSize: negative");
+    check(!parseWholeSize("12a", value), "parseSize: trailing character");
+
+    const std::string withSpace = "42 ";
+    const char *last = withSpace.data() + withSpace.size();
+    check(parseSize(withSpace.data(), last, value) == withSpace.data() + 2 &&
+              value == 42,
+          "parseSize: stops at space");
+}
+
+// ----------------------------------------
+// parseFloat
+// ----------------------------------------
+
+void testParseFloat() {
+    float value;
+
+    check(parseWholeFloat("0", value) && value == 0.0f, "parseFloat: 0");
+    check(parseWholeFloat("-1.5", value) && value == -1.5f,
+          "parseFloat: -1.5");
+    check(parseWholeFloat("+2.25e2", value) && value == 225.0f,
+          "parseFloat: +2.25e2");
+    check(parseWholeFloat("0.1", value) && value == 0.1f, "parseFloat: 0.1");
+    check(parseWholeFloat("123.456789", value) && value == 123.456789f,
+          "parseFloat: 123.456789");
+    check(parseWholeFloat("3.4e38", value) && value == 3.4e38f,
+          "parseFloat: 3.4e38");
+    check(parseWholeFloat("1e-999", value) && value == 0.0f,
+          "parseFloat: 1e-999");
+
+    check(!parseWholeFloat("3.5e39", value), "parseFloat: 3.5e39");
+    check(!parseWholeFloat("-3.5e39", value), "parseFloat: -3.5e39");
+    check(!parseWholeFloat("1e999", value), "parseFloat: 1e999");
+
+    check(!parseWholeFloat("", value), "parseFloat: empty");
+    check(!parseWholeFloat("-", value), "parseFloat: sign only");
+    check(!parseWholeFloat("1.0x", value), "parseFloat: trailing character");
+}
+
+int main() {
+    testParseSize();
+    testParseFloat();
+
+    if (numOfFailures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", numOfFailures);
+        return 1;
+    }
+    return 0;
+}